@@ -286,6 +286,14 @@ int i;
   return true;
 }
 
+// **************************************************************
+bool wavTrigger::isReady(void) {
+
+  // True once both replies to the requests sent by start() are in
+  update();
+  return (versionRcvd && sysinfoRcvd);
+}
+
 // **************************************************************
 int wavTrigger::getNumTracks(void) {
 
@@ -529,7 +537,9 @@ boolean AudioHandler::InitDevices(byte audioType) {
   if (audioType & AUDIO_PLAY_TYPE_WAV_TRIGGER) {
     // WAV Trigger startup at 57600
     wTrig.start();
-    delay(10);
+    // Go on as soon as it answers
+    unsigned long startTime = millis();
+    while (!wTrig.isReady() && (millis()-startTime)<WAV_TRIGGER_STARTUP_TIMEOUT);
     wTrig.stopAllTracks();
     wTrig.samplerateOffset(0);
     wTrig.setReporting(true);
@@ -89,6 +89,9 @@ struct SoundEffectEntry {
 #define MAX_NUM_VOICES          14
 #define VERSION_STRING_LEN        21
 
+// Longest wait at startup for the version and system info replies
+#define WAV_TRIGGER_STARTUP_TIMEOUT   10
+
 #define SOM1  0xf0
 #define SOM2  0xaa
 #define EOM   0x55
@@ -113,6 +116,7 @@ public:
   void setReporting(bool enable);
   void setAmpPwr(bool enable);
   bool getVersion(char *pDst, int len);
+  bool isReady(void);
   int getNumTracks(void);
   bool isTrackPlaying(int trk);
   int getPlayingTrack(int voiceNum);
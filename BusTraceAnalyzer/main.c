@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Frame layout and flag bits have to match the Bus Trace section of RPU.cpp
+#define TRACE_VERSION		1
+#define TRACE_HEADER_SIZE	12
+#define TRACE_ENTRY_SIZE	4
+#define TRACE_READ		0x80
+#define TRACE_PASS_MARKER	0x40
+#define TRACE_SECTION_MASK	0x07
+#define TRACE_PASS_END		0x80
+#define NUM_SECTIONS		8
+#define NUM_HANDLERS		3
+#define MAX_PASS_DEPTH		8
+#define MAX_ADDRESSES		65536
+#define BAR_WIDTH		40
+
+
+struct traceEntry {
+unsigned short address;
+unsigned char data;
+unsigned char flags;
+};
+
+struct addressStats {
+unsigned long reads;
+unsigned long writes;
+unsigned long sectionCycles[NUM_SECTIONS];
+unsigned long repeatedWrites;
+unsigned long backToBackWrites;
+unsigned long repeatedBySection[NUM_SECTIONS];
+int lastWrite;
+int lastRepeatedValue;
+};
+
+struct passState {
+int handler;
+unsigned short startTime;
+int sinceLastStart;
+unsigned long reads;
+unsigned long writes;
+char timeline[512];
+int lastSection;
+unsigned long runReads;
+unsigned long runWrites;
+};
+
+const char *SectionNames[NUM_SECTIONS] = {
+	"other", "display", "switches", "solenoids", "lamps", "sound", "irq-check", "init"
+};
+
+const char *HandlerNames[NUM_HANDLERS] = { "timer", "irq", "scan" };
+
+struct addressStats AddressStats[MAX_ADDRESSES];
+int Verbose = 0;
+
+
+const char *AddressName(int architecture, unsigned short address) {
+	static char name[32];
+	const char *registerNames[4] = { "A", "A control", "B", "B control" };
+	const char *pia = NULL;
+
+	if (architecture<10) {
+		// Rev 3 and up, Rev 1, Rev 2
+		if ((address&0xFFFC)==0x88 || (address&0xFFFC)==0x14 || (address&0xFFFC)==0x00) pia = "U10";
+		if ((address&0xFFFC)==0x90 || (address&0xFFFC)==0x18 || (address&0xFFFC)==0x08) pia = "U11";
+	} else if ((address&0x00FC)==0) {
+		switch (address&0xFF00) {
+			case 0x2100: pia = (architecture==15) ? "sound/sol" : "sound/comma"; break;
+			case 0x2200: pia = "solenoid"; break;
+			case 0x2400: pia = "lamps"; break;
+			case 0x2800: pia = "display"; break;
+			case 0x2C00: pia = "alpha"; break;
+			case 0x3000: pia = "switch"; break;
+			case 0x3400: pia = "widget"; break;
+		}
+	}
+
+	if (pia==NULL) return "";
+	sprintf(name, "%s %s", pia, registerNames[address&0x03]);
+	return name;
+}
+
+
+void PrintBar(unsigned long value, unsigned long maxValue) {
+	int count = maxValue ? (int)((value*BAR_WIDTH + maxValue - 1)/maxValue) : 0;
+	for (int i=0; i<count; i++) printf("#");
+}
+
+
+void PrintHistogram(int architecture) {
+	unsigned long maxCycles = 0;
+
+	printf("\nPer-address histogram\n");
+	printf("  address  register            reads  writes  sections\n");
+	for (int address=0; address<MAX_ADDRESSES; address++) {
+		unsigned long cycles = AddressStats[address].reads + AddressStats[address].writes;
+		if (cycles>maxCycles) maxCycles = cycles;
+	}
+
+	for (int address=0; address<MAX_ADDRESSES; address++) {
+		struct addressStats *stats = &AddressStats[address];
+		if (stats->reads==0 && stats->writes==0) continue;
+
+		printf("  0x%04X   %-18s %6lu  %6lu  ", address, AddressName(architecture, address), stats->reads, stats->writes);
+		for (int section=0; section<NUM_SECTIONS; section++) {
+			if (stats->sectionCycles[section]) printf("%s %lu  ", SectionNames[section], stats->sectionCycles[section]);
+		}
+		printf("\n           ");
+		PrintBar(stats->reads + stats->writes, maxCycles);
+		printf("\n");
+	}
+}
+
+
+void PrintRedundantWrites(int architecture) {
+	unsigned long totalWrites = 0, totalRepeated = 0;
+
+	printf("\nRedundant writes (same value as the last write to that address)\n");
+	printf("  address  register            writes  repeated  back-to-back  sections\n");
+	for (int address=0; address<MAX_ADDRESSES; address++) {
+		struct addressStats *stats = &AddressStats[address];
+		totalWrites += stats->writes;
+		totalRepeated += stats->repeatedWrites;
+		if (stats->repeatedWrites==0) continue;
+
+		printf("  0x%04X   %-18s %6lu  %5lu (%2lu%%)  %8lu      ", address, AddressName(architecture, address),
+			stats->writes, stats->repeatedWrites, (100*stats->repeatedWrites)/stats->writes, stats->backToBackWrites);
+		for (int section=0; section<NUM_SECTIONS; section++) {
+			if (stats->repeatedBySection[section]) printf("%s %lu  ", SectionNames[section], stats->repeatedBySection[section]);
+		}
+		printf("(e.g. 0x%02X)\n", stats->lastRepeatedValue);
+	}
+	printf("  %lu of %lu writes repeated the last value\n", totalRepeated, totalWrites);
+}
+
+
+void FlushRun(struct passState *pass) {
+	char run[64];
+	if (pass->runReads==0 && pass->runWrites==0) return;
+
+	if (pass->runReads && pass->runWrites) sprintf(run, " %s %lur/%luw", SectionNames[pass->lastSection], pass->runReads, pass->runWrites);
+	else if (pass->runReads) sprintf(run, " %s %lur", SectionNames[pass->lastSection], pass->runReads);
+	else sprintf(run, " %s %luw", SectionNames[pass->lastSection], pass->runWrites);
+	if (strlen(pass->timeline) + strlen(run) < sizeof(pass->timeline) - 4) strcat(pass->timeline, run);
+	else if (strstr(pass->timeline, " ...")==NULL) strcat(pass->timeline, " ...");
+
+	pass->runReads = 0;
+	pass->runWrites = 0;
+}
+
+
+void AddToTimeline(struct passState *pass, const char *text) {
+	FlushRun(pass);
+	if (strlen(pass->timeline) + strlen(text) < sizeof(pass->timeline) - 4) strcat(pass->timeline, text);
+}
+
+
+void AnalyzeFrame(const unsigned char *frame, int frameNum) {
+	int architecture = frame[5];
+	unsigned int count = frame[6] | (frame[7]<<8);
+	unsigned long recorded = frame[8] | (frame[9]<<8) | ((unsigned long)frame[10]<<16) | ((unsigned long)frame[11]<<24);
+	const unsigned char *entryBytes = frame + TRACE_HEADER_SIZE;
+
+	struct passState passStack[MAX_PASS_DEPTH];
+	int passDepth = 0;
+	int lastStart[NUM_HANDLERS] = { -1, -1, -1 };
+	unsigned long passCount[NUM_HANDLERS] = { 0, 0, 0 };
+	unsigned long passMicros[NUM_HANDLERS] = { 0, 0, 0 };
+	unsigned long passMaxMicros[NUM_HANDLERS] = { 0, 0, 0 };
+	unsigned long passCycles[NUM_HANDLERS] = { 0, 0, 0 };
+	struct traceEntry previous = { 0, 0, TRACE_PASS_MARKER };
+
+	memset(AddressStats, 0, sizeof(AddressStats));
+	for (int address=0; address<MAX_ADDRESSES; address++) AddressStats[address].lastWrite = -1;
+
+	printf("Frame %d: architecture %d, %u entries (%lu bus cycles recorded", frameNum, architecture, count, recorded);
+	if (recorded>count) printf(", oldest %lu overwritten", recorded-count);
+	printf(")\n");
+	printf("\nPass timeline, in the order passes finish\n(start us, time since the last start, duration, bus cycles by section, [nested pass])\n");
+
+	for (unsigned int entryNum=0; entryNum<count; entryNum++) {
+		struct traceEntry entry;
+		entry.address = entryBytes[0] | (entryBytes[1]<<8);
+		entry.data = entryBytes[2];
+		entry.flags = entryBytes[3];
+		entryBytes += TRACE_ENTRY_SIZE;
+
+		if (entry.flags & TRACE_PASS_MARKER) {
+			int handler = entry.data & 0x7F;
+			if (handler>=NUM_HANDLERS) handler = 0;
+
+			if ((entry.data & TRACE_PASS_END)==0) {
+				char nested[32];
+				if (passDepth) {
+					sprintf(nested, " [%s]", HandlerNames[handler]);
+					AddToTimeline(&passStack[passDepth-1], nested);
+				}
+				if (passDepth<MAX_PASS_DEPTH) {
+					struct passState *pass = &passStack[passDepth];
+					memset(pass, 0, sizeof(struct passState));
+					pass->handler = handler;
+					pass->startTime = entry.address;
+					pass->sinceLastStart = (lastStart[handler]>=0) ? (unsigned short)(entry.address - lastStart[handler]) : -1;
+					pass->lastSection = -1;
+				}
+				lastStart[handler] = entry.address;
+				passDepth += 1;
+			} else if (passDepth) {
+				passDepth -= 1;
+				if (passDepth<MAX_PASS_DEPTH) {
+					struct passState *pass = &passStack[passDepth];
+					unsigned short duration = entry.address - pass->startTime;
+					FlushRun(pass);
+					printf("  %5u", pass->startTime);
+					if (pass->sinceLastStart>=0) printf("  +%5d", pass->sinceLastStart);
+					else printf("        ");
+					printf("  %-5s %5u us %4lu:%s\n", HandlerNames[pass->handler], duration, pass->reads + pass->writes, pass->timeline);
+					passCount[pass->handler] += 1;
+					passMicros[pass->handler] += duration;
+					passCycles[pass->handler] += pass->reads + pass->writes;
+					if (duration>passMaxMicros[pass->handler]) passMaxMicros[pass->handler] = duration;
+				}
+			}
+			previous = entry;
+			continue;
+		}
+
+		int section = entry.flags & TRACE_SECTION_MASK;
+		struct addressStats *stats = &AddressStats[entry.address];
+		stats->sectionCycles[section] += 1;
+
+		if (entry.flags & TRACE_READ) {
+			stats->reads += 1;
+		} else {
+			stats->writes += 1;
+			if (stats->lastWrite==entry.data) {
+				stats->repeatedWrites += 1;
+				stats->repeatedBySection[section] += 1;
+				stats->lastRepeatedValue = entry.data;
+				if (previous.address==entry.address && previous.data==entry.data && (previous.flags & (TRACE_READ|TRACE_PASS_MARKER))==0) {
+					stats->backToBackWrites += 1;
+				}
+			}
+			stats->lastWrite = entry.data;
+		}
+
+		if (passDepth && passDepth<=MAX_PASS_DEPTH) {
+			struct passState *pass = &passStack[passDepth-1];
+			if (section!=pass->lastSection) {
+				FlushRun(pass);
+				pass->lastSection = section;
+			}
+			if (entry.flags & TRACE_READ) {
+				pass->reads += 1;
+				pass->runReads += 1;
+			} else {
+				pass->writes += 1;
+				pass->runWrites += 1;
+			}
+		}
+
+		if (Verbose) {
+			printf("    %s 0x%04X %-18s 0x%02X  %s\n", (entry.flags & TRACE_READ) ? "rd" : "wr", entry.address,
+				AddressName(architecture, entry.address), entry.data, SectionNames[section]);
+		}
+		previous = entry;
+	}
+
+	printf("\nPass summary\n");
+	for (int handler=0; handler<NUM_HANDLERS; handler++) {
+		if (passCount[handler]==0) continue;
+		printf("  %-5s %4lu complete passes, avg %lu us (max %lu us), avg %lu bus cycles\n", HandlerNames[handler],
+			passCount[handler], passMicros[handler]/passCount[handler], passMaxMicros[handler], passCycles[handler]/passCount[handler]);
+	}
+
+	PrintHistogram(architecture);
+	PrintRedundantWrites(architecture);
+	printf("\n");
+}
+
+
+int main(int argc, char **argv) {
+	const char *fileName = NULL;
+	for (int argNum=1; argNum<argc; argNum++) {
+		if (strcmp(argv[argNum], "-v")==0) Verbose = 1;
+		else fileName = argv[argNum];
+	}
+	if (fileName==NULL) {
+		fprintf(stderr, "usage: %s [-v] <captured serial output>\n", argv[0]);
+		return 1;
+	}
+
+	FILE *traceFile = fopen(fileName, "rb");
+	if (traceFile==NULL) {
+		fprintf(stderr, "Can't open %s\n", fileName);
+		return 1;
+	}
+	fseek(traceFile, 0, SEEK_END);
+	long fileSize = ftell(traceFile);
+	fseek(traceFile, 0, SEEK_SET);
+	unsigned char *buffer = malloc(fileSize>0 ? fileSize : 1);
+	if (buffer==NULL || fread(buffer, 1, fileSize, traceFile)!=(size_t)fileSize) {
+		fprintf(stderr, "Can't read %s\n", fileName);
+		return 1;
+	}
+	fclose(traceFile);
+
+	// The capture can have other serial output (debug messages) between frames
+	int numFrames = 0;
+	for (long pos=0; pos+TRACE_HEADER_SIZE+2<=fileSize; pos++) {
+		if (memcmp(buffer+pos, "RPUT", 4)) continue;
+
+		const unsigned char *frame = buffer + pos;
+		unsigned int count = frame[6] | (frame[7]<<8);
+		long frameSize = TRACE_HEADER_SIZE + (long)count*TRACE_ENTRY_SIZE + 2;
+		if (frame[4]!=TRACE_VERSION || pos+frameSize>fileSize) continue;
+
+		unsigned short checksum = 0;
+		for (long byteNum=4; byteNum<frameSize-2; byteNum++) checksum += frame[byteNum];
+		if (checksum!=(frame[frameSize-2] | (frame[frameSize-1]<<8))) {
+			fprintf(stderr, "Skipping frame at offset %ld (bad checksum)\n", pos);
+			continue;
+		}
+
+		numFrames += 1;
+		AnalyzeFrame(frame, numFrames);
+		pos += frameSize - 1;
+	}
+
+	if (numFrames==0) {
+		fprintf(stderr, "No bus trace frames found in %s\n", fileName);
+		return 1;
+	}
+	free(buffer);
+	return 0;
+}
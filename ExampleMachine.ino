@@ -336,6 +336,10 @@ void setup() {
     Serial.begin(115200);
     Serial.write("Starting\n");
   }
+#ifdef RPU_OS_USE_BUS_TRACE
+  // The bus trace is dumped over Serial
+  if (!DEBUG_MESSAGES) Serial.begin(115200);
+#endif
 
   // Set up the Audio handler in order to play boot messages
   CurrentTime = millis();
@@ -368,7 +372,19 @@ void setup() {
     Serial.write(buf);
     if (initResult&RPU_RET_6800_DETECTED) Serial.write("Detected 6800 clock\n");
     else if (initResult&RPU_RET_6802_OR_8_DETECTED) Serial.write("Detected 6802/8 clock\n");
+    if (initResult&RPU_RET_BOARD_NOT_READY) Serial.write("MPU board didn't come out of reset in time\n");
+    if (initResult&RPU_RET_DATA_LINE_ERROR) Serial.write("MPU data bus test failed\n");
+    if (initResult&RPU_RET_ARCHITECTURE_MISMATCH) {
+      sprintf(buf, "MPU board looks like architecture %d, not %d\n", RPU_GetDetectedArchitecture(), RPU_MPU_ARCHITECTURE);
+      Serial.write(buf);
+    }
     Serial.write("Back from init\n");
+
+    const char *bootPhaseNames[RPU_NUM_BOOT_PHASES] = {"clock check", "board ready", "boot select", "PIA setup", "PIA test", "interrupts"};
+    for (byte phase=0; phase<RPU_NUM_BOOT_PHASES; phase++) {
+      sprintf(buf, "  %s: %lu us\n", bootPhaseNames[phase], RPU_GetBootPhaseMicros(phase));
+      Serial.write(buf);
+    }
   }
   
   if (initResult & RPU_RET_SELECTOR_SWITCH_ON) QueueDIAGNotification(SOUND_EFFECT_DIAG_SELECTOR_SWITCH_ON);
@@ -395,6 +411,13 @@ void setup() {
   RPU_DisableSolenoidStack();
   RPU_SetDisableFlippers(true);
 
+  // Letting go of the credit button ends a hold to reset the game
+  RPU_SetSwitchOpenEvents(SW_CREDIT_RESET);
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  // A fast spin shouldn't crowd coins and tilts off the switch stack
+  RPU_SetSwitchCoalescing(SW_SPINNER);
+#endif
+
   // Read parameters from EEProm
   ReadStoredParameters();
   RPU_SetCoinLockout((Credits >= MaximumCredits) ? true : false);
@@ -417,6 +440,12 @@ void setup() {
 
   Audio.SetMusicDuckingGain(12);
   Audio.QueueSound(SOUND_EFFECT_MACHINE_START, AUDIO_PLAY_TYPE_WAV_TRIGGER, CurrentTime+1200);
+
+  if (DEBUG_MESSAGES) {
+    char buf[64];
+    sprintf(buf, "Setup done at %lu ms\n", millis());
+    Serial.write(buf);
+  }
 }
 
 byte ReadSetting(byte setting, byte defaultValue) {
@@ -969,38 +998,29 @@ void IncreasePlayfieldMultiplier(unsigned long duration) {
 /*
 
 // Some example lock functionality
+// (setup calls RPU_SetSwitchOpenEvents for SW_LOCK_1-3, and the game
+// play switch loop hands every lock switch event to LockSwitchEvent,
+// so the lock switches aren't read every loop)
 unsigned long UpperLockSwitchDownTime[3] = {0, 0, 0};
 unsigned long UpperLockSwitchUpTime[3] = {0, 0, 0};
 boolean UpperLockSwitchState[3] = {false, false, false};
 
-void UpdateLockStatus() {
-  boolean lockSwitchDownTransition;
-  boolean lockSwitchUpTransition;
+void LockSwitchEvent(byte lockIndex, byte edge, unsigned long eventTime) {
+  if (edge==RPU_SWITCH_EDGE_CLOSED) {
+    UpperLockSwitchUpTime[lockIndex] = 0;
+    UpperLockSwitchDownTime[lockIndex] = eventTime;
+  } else {
+    UpperLockSwitchDownTime[lockIndex] = 0;
+    UpperLockSwitchUpTime[lockIndex] = eventTime;
+  }
+}
 
+void UpdateLockStatus() {
   for (byte count=0; count<3; count++) {
-    lockSwitchDownTransition = false;
-    lockSwitchUpTransition = false;
-
-    if (RPU_ReadSingleSwitchState(SW_LOCK_1+count)) {
-      UpperLockSwitchUpTime[count] = 0;
-      if (UpperLockSwitchDownTime[count]==0) {
-        UpperLockSwitchDownTime[count] = CurrentTime;
-      } else if (CurrentTime > (UpperLockSwitchDownTime[count] + 250)) {
-        lockSwitchDownTransition = true;
-      }
-    } else {
-      UpperLockSwitchDownTime[count] = 0;
-      if (UpperLockSwitchUpTime[count]==0) {
-        UpperLockSwitchUpTime[count] = CurrentTime;
-      } else if (CurrentTime > (UpperLockSwitchUpTime[count] + 250)) {
-        lockSwitchUpTransition = true;
-      }
-    }
-
-    if (lockSwitchUpTransition && UpperLockSwitchState[count]) {
+    if (UpperLockSwitchUpTime[count] && UpperLockSwitchState[count] && CurrentTime > (UpperLockSwitchUpTime[count] + 250)) {
       // if we used to be down & now we're up
       UpperLockSwitchState[count] = false;
-    } else if (lockSwitchDownTransition && !UpperLockSwitchState[count]) {
+    } else if (UpperLockSwitchDownTime[count] && !UpperLockSwitchState[count] && CurrentTime > (UpperLockSwitchDownTime[count] + 250)) {
       // if we used to be up & now we're down
       UpperLockSwitchState[count] = true;
       HandleLockSwitch(count);
@@ -1054,8 +1074,16 @@ int RunSelfTest(int curState, boolean curStateChanged) {
     Audio.StopAllAudio();
     RPU_TurnOffAllLamps();
     Audio.StopAllAudio();
-    int modeMapping = SelfTestStateToCalloutMap[-1 - curState];
-    Audio.PlaySound((unsigned short)modeMapping, AUDIO_PLAY_TYPE_WAV_TRIGGER, 10);
+    int calloutIndex = -1 - curState;
+#ifdef RPU_OS_USE_ISR_STATS
+    // The ISR stats page has no callout, and the states after it are one further down
+    if (curState==MACHINE_STATE_TEST_ISR_STATS) calloutIndex = -1;
+    else if (curState<MACHINE_STATE_TEST_ISR_STATS) calloutIndex -= 1;
+#endif
+    if (calloutIndex>=0) {
+      int modeMapping = SelfTestStateToCalloutMap[calloutIndex];
+      Audio.PlaySound((unsigned short)modeMapping, AUDIO_PLAY_TYPE_WAV_TRIGGER, 10);
+    }
   } else {
     if (SoundSettingTimeout && CurrentTime>SoundSettingTimeout) {
       SoundSettingTimeout = 0;
@@ -1408,6 +1436,21 @@ int RunDiagnosticsMode(int curState, boolean curStateChanged) {
 
   if (curStateChanged) {
 
+    // Walk the PIAs and the data bus, and show how long a bus
+    // access takes (read ns on display 1, write ns on display 2)
+    RPUBusTestResults busTest;
+    unsigned long busErrors = RPU_TestBus(&busTest);
+    RPU_SetDisplay(0, busTest.readNanoseconds, true);
+    RPU_SetDisplay(1, busTest.writeNanoseconds, true);
+    if (DEBUG_MESSAGES) {
+      char buf[128];
+      sprintf(buf, "Bus test errors=0x%05lX, stuck high=0x%02X, stuck low=0x%02X, shorted=0x%02X\n", busErrors, 
+              busTest.stuckHighLines, busTest.stuckLowLines, busTest.shortedLines);
+      Serial.write(buf);
+      sprintf(buf, "Bus access: read=%u ns, write=%u ns\n", busTest.readNanoseconds, busTest.writeNanoseconds);
+      Serial.write(buf);
+    }
+
 /*
     char buf[256];
     boolean errorSeen;
@@ -2413,7 +2456,7 @@ void HandleDropTarget(byte switchHit) {
 
 
 
-void HandleGamePlaySwitches(byte switchHit) {
+void HandleGamePlaySwitches(byte switchHit, byte hitCount) {
 
   switch (switchHit) {
 
@@ -2434,7 +2477,7 @@ void HandleGamePlaySwitches(byte switchHit) {
       break;
 
     case SW_SPINNER:
-      CurrentScores[CurrentPlayer] += 100 * PlayfieldMultiplier;
+      CurrentScores[CurrentPlayer] += 100 * PlayfieldMultiplier * hitCount;
 //      PlaySoundEffect(SOUND_EFFECT_SPINNER);
       LastSwitchHitTime = CurrentTime;
       if (BallFirstSwitchHitTime == 0) BallFirstSwitchHitTime = CurrentTime;
@@ -2498,12 +2541,17 @@ int RunGamePlayMode(int curState, boolean curStateChanged) {
     returnState = ShowMatchSequence(curStateChanged);
   }
 
-  byte switchHit;
+  RPUSwitchEvent switchEvent;
   unsigned long lastBallFirstSwitchHitTime = BallFirstSwitchHitTime;
 
-  while ( (switchHit = RPU_PullFirstFromSwitchStack()) != SWITCH_STACK_EMPTY ) {
-    returnState = HandleSystemSwitches(curState, switchHit);
-    if (NumTiltWarnings <= MaxTiltWarnings) HandleGamePlaySwitches(switchHit);
+  while (RPU_PullFirstSwitchEvent(&switchEvent)) {
+    if (switchEvent.edge==RPU_SWITCH_EDGE_OPENED) {
+      // The credit button was let go, so it's not being held
+      if (switchEvent.switchNum==SW_CREDIT_RESET) CreditResetPressStarted = 0;
+      continue;
+    }
+    returnState = HandleSystemSwitches(curState, switchEvent.switchNum);
+    if (NumTiltWarnings <= MaxTiltWarnings) HandleGamePlaySwitches(switchEvent.switchNum, switchEvent.count);
   }
 
   if (CreditResetPressStarted) {
@@ -2514,21 +2562,19 @@ int RunGamePlayMode(int curState, boolean curStateChanged) {
         Serial.write("Start game button pressed\n\r");
       }
       CreditResetPressStarted = 0;
-    } else {
-      if (RPU_ReadSingleSwitchState(SW_CREDIT_RESET)) {
-        if (TimeRequiredToResetGame != 99 && (CurrentTime - CreditResetPressStarted) >= ((unsigned long)TimeRequiredToResetGame*1000)) {
-          // If the first ball is over, pressing start again resets the game
-          if (Credits >= 1 || FreePlayMode) {
-            if (!FreePlayMode) {
-              Credits -= 1;
-              RPU_WriteByteToEEProm(RPU_CREDITS_EEPROM_BYTE, Credits);
-              RPU_SetDisplayCredits(Credits, !FreePlayMode);
-            }
-            returnState = MACHINE_STATE_INIT_GAMEPLAY;
-            CreditResetPressStarted = 0;
-          }
+    } else if (TimeRequiredToResetGame != 99 && (CurrentTime - CreditResetPressStarted) >= ((unsigned long)TimeRequiredToResetGame*1000)) {
+      // The button's been held (its open event would have cleared
+      // CreditResetPressStarted), so if the first ball is over, this resets the game.
+      // A full switch stack can drop the open, so check the button is still down.
+      if (!RPU_ReadSingleSwitchState(SW_CREDIT_RESET)) {
+        CreditResetPressStarted = 0;
+      } else if (Credits >= 1 || FreePlayMode) {
+        if (!FreePlayMode) {
+          Credits -= 1;
+          RPU_WriteByteToEEProm(RPU_CREDITS_EEPROM_BYTE, Credits);
+          RPU_SetDisplayCredits(Credits, !FreePlayMode);
         }
-      } else {
+        returnState = MACHINE_STATE_INIT_GAMEPLAY;
         CreditResetPressStarted = 0;
       }
     }
@@ -2613,6 +2659,11 @@ void loop() {
   RPU_Update(CurrentTime);
   Audio.Update(CurrentTime);
 
+#ifdef RPU_OS_USE_BUS_TRACE
+  // Send a 'T' over Serial to get the recent bus cycles (see BusTraceAnalyzer)
+  if (Serial.available() && Serial.read()=='T') RPU_DumpBusTrace();
+#endif
+
 #if (RPU_MPU_ARCHITECTURE>=10)
   if (LastLEDUpdateTime == 0 || (CurrentTime - LastLEDUpdateTime) > 250) {
     LastLEDUpdateTime = CurrentTime;
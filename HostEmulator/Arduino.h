@@ -0,0 +1,119 @@
+/**************************************************************************
+ *   Host stand-in for the parts of the Arduino core that RPU.cpp uses.
+ *   Port registers are objects so that the emulator can watch VMA, R/W,
+ *   the address lines and the data lines exactly like the MPU board does.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define A0            54
+
+#define PROGMEM
+#define pgm_read_byte(addr)   (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t *)(addr))
+
+#define ISR(vector) void vector(void)
+
+#define WGM12   3
+#define CS10    0
+#define CS11    1
+#define CS12    2
+#define OCIE1A  1
+#define WGM21   1
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define OCIE2A  1
+#define OCF2A   1
+
+class HostRegister {
+  public:
+    explicit HostRegister(byte s_id) : id(s_id), value(0) {}
+    operator byte();
+    HostRegister &operator=(byte newValue);
+    HostRegister &operator|=(byte bits) { return (*this = (byte)(Peek() | bits)); }
+    HostRegister &operator&=(byte bits) { return (*this = (byte)(Peek() & bits)); }
+    HostRegister &operator^=(byte bits) { return (*this = (byte)(Peek() ^ bits)); }
+    byte Peek() { return value; }
+
+    byte id;
+    byte value;
+};
+
+// Writing a counter restarts its timer
+class HostTimerCounter {
+  public:
+    explicit HostTimerCounter(byte s_timer) : timer(s_timer) {}
+    operator uint16_t();
+    HostTimerCounter &operator=(uint16_t newValue);
+
+    byte timer;
+};
+
+#define HOST_DECLARE_PORT(x) extern HostRegister DDR##x, PORT##x, PIN##x;
+HOST_DECLARE_PORT(A) HOST_DECLARE_PORT(B) HOST_DECLARE_PORT(C) HOST_DECLARE_PORT(D)
+HOST_DECLARE_PORT(E) HOST_DECLARE_PORT(F) HOST_DECLARE_PORT(G) HOST_DECLARE_PORT(H)
+HOST_DECLARE_PORT(J) HOST_DECLARE_PORT(K) HOST_DECLARE_PORT(L)
+
+// (timer 0 is the free-running millis timer, /64)
+extern HostTimerCounter TCNT0;
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1;
+extern volatile uint16_t OCR1A;
+extern HostTimerCounter TCNT1;
+extern volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TIFR2, OCR2A;
+extern HostTimerCounter TCNT2;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void cli();
+void sei();
+#define noInterrupts() cli()
+#define interrupts() sei()
+
+void pinMode(byte pin, byte mode);
+void digitalWrite(byte pin, byte value);
+int digitalRead(byte pin);
+#define digitalPinToInterrupt(p) ((p)==2 ? 0 : -1)
+void attachInterrupt(int interruptNum, void (*handler)(void), int mode);
+
+// Status register (only the interrupt flag, bit 7, is modeled)
+class HostStatusRegister {
+  public:
+    operator byte();
+    HostStatusRegister &operator=(byte newValue);
+};
+extern HostStatusRegister SREG;
+
+// Has RPU.cpp keep CurrentBusSection up to date, so the emulator can
+// charge bus cycles to the part of the code that issued them
+#define RPU_OS_TRACK_BUS_SECTIONS
+
+class HostSerial {
+  public:
+    void begin(unsigned long) {}
+    size_t write(byte value);
+    size_t write(const char *text);
+    size_t write(const byte *buffer, size_t length);
+    int available();
+    int read();
+    void flush() {}
+};
+extern HostSerial Serial;
+
+#endif
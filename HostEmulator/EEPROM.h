@@ -0,0 +1,22 @@
+/**************************************************************************
+ *   Host stand-in for the Arduino EEPROM library (4K, erased to 0xFF)
+ */
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include "Arduino.h"
+
+#define HOST_EEPROM_SIZE  4096
+
+class HostEEPROM {
+  public:
+    HostEEPROM() { memset(contents, 0xFF, sizeof(contents)); }
+    byte read(int address) { return contents[address % HOST_EEPROM_SIZE]; }
+    void write(int address, byte value) { contents[address % HOST_EEPROM_SIZE] = value; }
+    void update(int address, byte value) { write(address, value); }
+
+    byte contents[HOST_EEPROM_SIZE];
+};
+extern HostEEPROM EEPROM;
+
+#endif
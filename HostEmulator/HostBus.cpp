@@ -0,0 +1,906 @@
+/**************************************************************************
+ *   Emulated MPU board for host builds of RPU.cpp
+ *
+ *   Cost model (16 MHz AVR cycles, approximate):
+ *     - PINx read 4 (it's almost always inside a spin loop)
+ *     - other register read 1, register write 2
+ *     - 12 per bus cycle for the call into RPU_DataWrite/RPU_DataRead
+ *     - delay()/delayMicroseconds() at face value
+ *   Plain C arithmetic inside the library is not charged, so the numbers
+ *   are bus + wait cost, which is what dominates the interrupt code.
+ */
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "RPU_Config.h"
+#include "HostBus.h"
+#include <map>
+
+#if !((RPU_OS_HARDWARE_REV==4) || (RPU_OS_HARDWARE_REV==101) || (RPU_OS_HARDWARE_REV==102))
+#error "The host emulator models the Rev 4 and Rev 101/102 port layout"
+#endif
+
+void TIMER1_COMPA_vect(void);
+// (only builds that use timer 2 have this one)
+void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern volatile byte CurrentBusSection;
+
+#define HOST_E_CLOCK_HZ       894886UL
+#define HOST_ZERO_CROSS_HZ    120
+#define HOST_U11_DISPLAY_HZ   320
+#define HOST_CALL_OVERHEAD    12
+
+enum { HOST_DDR = 0, HOST_PORT = 1, HOST_PIN = 2 };
+enum { HP_A = 0, HP_B, HP_C, HP_D, HP_E, HP_F, HP_G, HP_H, HP_J, HP_K, HP_L, HOST_NUM_PORTS };
+
+#define HOST_DEFINE_PORT(x) \
+  HostRegister DDR##x(HP_##x*3 + HOST_DDR), PORT##x(HP_##x*3 + HOST_PORT), PIN##x(HP_##x*3 + HOST_PIN);
+HOST_DEFINE_PORT(A) HOST_DEFINE_PORT(B) HOST_DEFINE_PORT(C) HOST_DEFINE_PORT(D)
+HOST_DEFINE_PORT(E) HOST_DEFINE_PORT(F) HOST_DEFINE_PORT(G) HOST_DEFINE_PORT(H)
+HOST_DEFINE_PORT(J) HOST_DEFINE_PORT(K) HOST_DEFINE_PORT(L)
+
+static HostRegister *HostPorts[HOST_NUM_PORTS] = {&PORTA, &PORTB, &PORTC, &PORTD, &PORTE, &PORTF, &PORTG, &PORTH, &PORTJ, &PORTK, &PORTL};
+static HostRegister *HostDDRs[HOST_NUM_PORTS] = {&DDRA, &DDRB, &DDRC, &DDRD, &DDRE, &DDRF, &DDRG, &DDRH, &DDRJ, &DDRK, &DDRL};
+
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1;
+volatile uint16_t OCR1A;
+HostTimerCounter TCNT0(0);
+HostTimerCounter TCNT1(1);
+volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TIFR2, OCR2A;
+HostTimerCounter TCNT2(2);
+HostStatusRegister SREG;
+HostSerial Serial;
+HostEEPROM EEPROM;
+
+unsigned long long HostCycles = 0;
+HostBusCounters HostSectionCounters[HOST_NUM_SECTIONS];
+HostISRCounters HostTimerISRCounters;
+HostISRCounters HostTimer2ISRCounters;
+HostISRCounters HostIRQCounters;
+unsigned long long HostISRBusyCycles = 0;
+unsigned long HostMainLoopIterations = 0;
+
+static std::map<unsigned int, HostBusCounters> HostAddressCounters;
+static unsigned long HostTotalReads = 0, HostTotalWrites = 0;
+static unsigned long long HostBusWork = 0, HostBusWorkAtLastEnd = 0;
+static unsigned long long HostStatsStart = 0;
+static byte HostSection = 0;
+static FILE *HostSerialOut = NULL;
+static unsigned int HostCurrentAddress = 0;
+static byte HostDataIn = 0xFF;
+static byte HostLastBusData = 0xFF;
+static unsigned long long HostBoardResetEnd = 0;
+
+static boolean HostMPUClock = true;
+static boolean HostSelectorSwitch = true;
+static boolean HostInterruptsEnabled = false;
+static byte HostISRDepth = 0;
+static unsigned long long HostBusyStart = 0;
+static void (*HostAttachedISR)(void) = NULL;
+
+// [0] = timer 1, [1] = timer 2
+static unsigned long long HostTimerStart[2], HostNextTimer[2], HostTimerDue[2];
+static boolean HostTimerPending[2];
+static unsigned long long HostNextZeroCross = 0, HostNextU11Display = 0;
+
+static byte HostSwitchMatrix[8];
+static unsigned long long HostSwitchStrobeTime = 0;
+static unsigned long long HostMinSettleCycles = ~0ULL;
+
+// Sound commands (a new value on the W-type 2 sound port) and passes
+// with a sound on the port (Arch 10+)
+#if (RPU_MPU_ARCHITECTURE>=10)
+static byte HostLastSoundOut = 0x7F;
+#endif
+static unsigned long HostSoundCmds = 0, HostSoundCmdPasses = 0;
+
+// Time between display digit strobes (Arch 10+)
+static unsigned long long HostLastDisplayStrobe = 0;
+static unsigned long long HostDisplayStrobeMin = ~0ULL, HostDisplayStrobeMax = 0, HostDisplayStrobeTotal = 0;
+static unsigned long HostDisplayStrobes = 0;
+
+static unsigned long HostLampOn[HOST_MAX_LAMPS];
+static unsigned long HostLampSampleCount = 0;
+static unsigned long HostSolFires[HOST_MAX_SOLENOIDS];
+static unsigned long HostSolOn[HOST_MAX_SOLENOIDS];
+static boolean HostSolLast[HOST_MAX_SOLENOIDS];
+static unsigned long long HostSolFireCycle[HOST_MAX_SOLENOIDS];
+static byte HostMaxSolsOn = 0;
+
+
+/******************************************************
+ *   MC6821 model
+ */
+struct HostPIA {
+  const char *name;
+  unsigned int base;
+  byte cra, crb, ddra, ddrb, ora, orb;
+  byte (*inputA)(HostPIA *pia);
+  byte (*inputB)(HostPIA *pia);
+  void (*changed)(HostPIA *pia, byte reg, byte oldCR);
+};
+
+static boolean PIAControl2High(byte controlRegister) {
+  // CA2/CB2 in manual output mode follow bit 3
+  if ((controlRegister & 0x30)==0x30) return (controlRegister & 0x08) ? true : false;
+  return true;
+}
+
+static byte PIARead(HostPIA *pia, byte reg) {
+  byte inputs;
+  switch (reg) {
+    case 0:
+      if (!(pia->cra & 0x04)) return pia->ddra;
+      inputs = pia->inputA ? pia->inputA(pia) : 0xFF;
+      pia->cra &= 0x3F;
+      return (pia->ora & pia->ddra) | (inputs & ~pia->ddra);
+    case 1:
+      return pia->cra;
+    case 2:
+      if (!(pia->crb & 0x04)) return pia->ddrb;
+      inputs = pia->inputB ? pia->inputB(pia) : 0xFF;
+      pia->crb &= 0x3F;
+      return (pia->orb & pia->ddrb) | (inputs & ~pia->ddrb);
+    default:
+      return pia->crb;
+  }
+}
+
+static void PIAWrite(HostPIA *pia, byte reg, byte data) {
+  byte oldCR = (reg<2) ? pia->cra : pia->crb;
+  switch (reg) {
+    case 0: if (pia->cra & 0x04) pia->ora = data; else pia->ddra = data; break;
+    case 1: pia->cra = (pia->cra & 0xC0) | (data & 0x3F); break;
+    case 2: if (pia->crb & 0x04) pia->orb = data; else pia->ddrb = data; break;
+    default: pia->crb = (pia->crb & 0xC0) | (data & 0x3F); break;
+  }
+  if (pia->changed) pia->changed(pia, reg, oldCR);
+}
+
+#if (RPU_MPU_ARCHITECTURE<10)
+static boolean PIAIRQ(HostPIA *pia) {
+  return ((pia->cra & 0x81)==0x81) || ((pia->crb & 0x81)==0x81);
+}
+#endif
+
+
+/******************************************************
+ *   Machine models
+ */
+#if (RPU_MPU_ARCHITECTURE<10)
+
+// U10: PA = switch strobes / lamp address+data / display BCD+latch strobes
+//      PB = switch returns, CA2 = display blank/latch gate, CB2 = lamp strobe 1
+// U11: PA = display digit enables (b0 = latch strobe 5), PB = solenoids
+static byte U10InputB(HostPIA *pia);
+static void U10Changed(HostPIA *pia, byte reg, byte oldCR);
+static void U11Changed(HostPIA *pia, byte reg, byte oldCR);
+static HostPIA HostU10 = {"U10", 0x88, 0, 0, 0, 0, 0, 0, NULL, U10InputB, U10Changed};
+static HostPIA HostU11 = {"U11", 0x90, 0, 0, 0, 0, 0, 0, NULL, NULL, U11Changed};
+static HostPIA *HostPIAs[] = {&HostU10, &HostU11};
+
+static byte HostLampAddress = 0x0F;
+static boolean HostLampTriggered[HOST_MAX_LAMPS];
+static byte HostDisplayLatch[5];
+static byte HostDisplayShown[5][8];
+
+static byte U10InputB(HostPIA *pia) {
+  byte returns = 0;
+  byte strobes = pia->ora;
+  if (strobes && !(strobes & (strobes-1))) {
+    unsigned long long settle = HostCycles - HostSwitchStrobeTime;
+    if (settle<HostMinSettleCycles) HostMinSettleCycles = settle;
+  }
+  for (byte col=0; col<5; col++) {
+    if (strobes & (1<<col)) returns |= HostSwitchMatrix[col];
+  }
+  return returns;
+}
+
+static void HostUpdateDisplayLatches() {
+  if (PIAControl2High(HostU10.cra)) return;
+  for (byte display=0; display<4; display++) {
+    if (!(HostU10.ora & (1<<display))) HostDisplayLatch[display] = HostU10.ora>>4;
+  }
+  if ((HostU11.cra & 0x04) && !(HostU11.ora & 0x01)) HostDisplayLatch[4] = HostU10.ora>>4;
+}
+
+static void U10Changed(HostPIA *pia, byte reg, byte oldCR) {
+  if (reg==0 && (pia->cra & 0x04)) HostSwitchStrobeTime = HostCycles;
+
+  // Lamp address latch is transparent while CB2 is high
+  if (PIAControl2High(pia->crb)) HostLampAddress = pia->ora & 0x0F;
+  if (HostLampAddress<15) {
+    for (byte decoder=0; decoder<4; decoder++) {
+      if (!(pia->ora & (0x10<<decoder))) {
+        byte lampNum = (HostLampAddress/2)*8 + (HostLampAddress&1)*4 + decoder;
+        HostLampTriggered[lampNum] = true;
+      }
+    }
+  }
+
+  HostUpdateDisplayLatches();
+
+  // Rising CA2 ends blanking - the enabled digit shows the latched values
+  if (reg==1 && !PIAControl2High(oldCR) && PIAControl2High(pia->cra)) {
+    for (byte digit=0; digit<RPU_OS_NUM_DIGITS; digit++) {
+#ifdef RPU_OS_USE_7_DIGIT_DISPLAYS
+      byte enableBit = 0x02<<digit;
+#else
+      byte enableBit = 0x04<<digit;
+#endif
+      if (HostU11.ora & enableBit) {
+        for (byte display=0; display<5; display++) HostDisplayShown[display][digit] = HostDisplayLatch[display];
+      }
+    }
+  }
+}
+
+static void U11Changed(HostPIA *pia, byte reg, byte oldCR) {
+  (void)pia; (void)reg; (void)oldCR;
+  HostUpdateDisplayLatches();
+}
+
+static void HostZeroCrossing() {
+  for (int lampNum=0; lampNum<HOST_MAX_LAMPS; lampNum++) {
+    if (HostLampTriggered[lampNum]) HostLampOn[lampNum] += 1;
+    HostLampTriggered[lampNum] = false;
+  }
+  HostLampSampleCount += 1;
+
+  byte solenoid = HostU11.orb & 0x0F;
+  for (byte solNum=0; solNum<16; solNum++) {
+    boolean on = (solenoid==solNum && solNum!=0x0F);
+    if (on) HostSolOn[solNum] += 1;
+    if (on && !HostSolLast[solNum]) HostSolFires[solNum] += 1;
+    HostSolLast[solNum] = on;
+  }
+
+  HostU10.crb |= 0x80;
+}
+
+#else
+
+static byte SwitchInputA(HostPIA *pia);
+static void WilliamsChanged(HostPIA *pia, byte reg, byte oldCR);
+static HostPIA HostDisplayPIA = {"Display", 0x2800, 0, 0, 0, 0, 0, 0, NULL, NULL, WilliamsChanged};
+static HostPIA HostSwitchPIA = {"Switch", 0x3000, 0, 0, 0, 0, 0, 0, SwitchInputA, NULL, WilliamsChanged};
+static HostPIA HostLampPIA = {"Lamps", 0x2400, 0, 0, 0, 0, 0, 0, NULL, NULL, WilliamsChanged};
+static HostPIA HostSolenoidPIA = {"Solenoid", 0x2200, 0, 0, 0, 0, 0, 0, NULL, NULL, WilliamsChanged};
+static HostPIA HostSoundPIA = {"Sound", 0x2100, 0, 0, 0, 0, 0, 0, NULL, NULL, WilliamsChanged};
+#if (RPU_MPU_ARCHITECTURE==15)
+static HostPIA HostAlphaPIA = {"Alpha", 0x2C00, 0, 0, 0, 0, 0, 0, NULL, NULL, WilliamsChanged};
+static HostPIA HostWidgetPIA = {"Widget", 0x3400, 0, 0, 0, 0, 0, 0, NULL, NULL, WilliamsChanged};
+static HostPIA *HostPIAs[] = {&HostDisplayPIA, &HostSwitchPIA, &HostLampPIA, &HostSolenoidPIA, &HostSoundPIA, &HostAlphaPIA, &HostWidgetPIA};
+#else
+// (the alpha display and widget PIAs are only on Sys 11 boards)
+static HostPIA *HostPIAs[] = {&HostDisplayPIA, &HostSwitchPIA, &HostLampPIA, &HostSolenoidPIA, &HostSoundPIA};
+#endif
+
+static byte HostDisplayShown[2][16];
+#if (RPU_MPU_ARCHITECTURE==15)
+// The alpha PIA's port A and port B (high and low byte) for each strobe
+static unsigned short HostAlphaShown[16];
+#endif
+
+static byte SwitchInputA(HostPIA *pia) {
+  byte returns = 0;
+  if (pia->orb && !(pia->orb & (pia->orb-1))) {
+    unsigned long long settle = HostCycles - HostSwitchStrobeTime;
+    if (settle<HostMinSettleCycles) HostMinSettleCycles = settle;
+  }
+  for (byte col=0; col<8; col++) {
+    if (pia->orb & (1<<col)) returns |= HostSwitchMatrix[col];
+  }
+  return returns;
+}
+
+static void WilliamsChanged(HostPIA *pia, byte reg, byte oldCR) {
+  (void)oldCR;
+  if (pia==&HostSoundPIA && reg==0 && (pia->cra & 0x04)) {
+    byte soundOut = pia->ora & 0x7F;
+    if (soundOut!=0x7F) {
+      if (soundOut!=HostLastSoundOut) HostSoundCmds += 1;
+      HostSoundCmdPasses += 1;
+    }
+    HostLastSoundOut = soundOut;
+  }
+  if (pia==&HostSwitchPIA && reg==2 && (pia->crb & 0x04)) HostSwitchStrobeTime = HostCycles;
+  if (pia==&HostLampPIA && reg==0 && (pia->cra & 0x04)) {
+    for (byte col=0; col<8; col++) {
+      if (pia->orb != (1<<col)) continue;
+      if (col==0) HostLampSampleCount += 1;
+      for (byte row=0; row<8; row++) {
+        if (!(pia->ora & (1<<row))) HostLampOn[col*8+row] += 1;
+      }
+    }
+  }
+  if (pia==&HostDisplayPIA && reg==0 && (pia->cra & 0x04)) {
+    if (HostLastDisplayStrobe) {
+      unsigned long long period = HostCycles - HostLastDisplayStrobe;
+      if (period<HostDisplayStrobeMin) HostDisplayStrobeMin = period;
+      if (period>HostDisplayStrobeMax) HostDisplayStrobeMax = period;
+      HostDisplayStrobeTotal += period;
+      HostDisplayStrobes += 1;
+    }
+    HostLastDisplayStrobe = HostCycles;
+  }
+#if (RPU_MPU_ARCHITECTURE==15)
+  if (pia==&HostAlphaPIA && reg==2) HostAlphaShown[HostDisplayPIA.ora & 0x0F] = (pia->ora<<8) | pia->orb;
+#endif
+  if (pia==&HostDisplayPIA && reg==2) {
+    byte strobe = HostDisplayPIA.ora & 0x0F;
+    HostDisplayShown[0][strobe] = pia->orb>>4;
+    HostDisplayShown[1][strobe] = pia->orb & 0x0F;
+  }
+}
+
+static void HostSampleSolenoids() {
+#if (RPU_MPU_ARCHITECTURE==15)
+  unsigned int bits = HostSolenoidPIA.ora | (HostSoundPIA.orb<<8);
+#else
+  unsigned int bits = HostSolenoidPIA.ora | (HostSolenoidPIA.orb<<8);
+#endif
+  byte specials[6] = {HostLampPIA.crb, HostLampPIA.cra, HostSwitchPIA.crb, HostSwitchPIA.cra, HostSolenoidPIA.cra, HostDisplayPIA.crb};
+  byte numOn = 0;
+  for (byte solNum=0; solNum<22; solNum++) {
+    boolean on;
+    if (solNum<16) on = (bits & (1<<solNum)) ? true : false;
+    else on = !PIAControl2High(specials[solNum-16]);
+    if (on) {
+      HostSolOn[solNum] += 1;
+      numOn += 1;
+    }
+    if (on && !HostSolLast[solNum]) {
+      HostSolFires[solNum] += 1;
+      HostSolFireCycle[solNum] = HostCycles;
+    }
+    HostSolLast[solNum] = on;
+  }
+  if (numOn>HostMaxSolsOn) HostMaxSolsOn = numOn;
+}
+
+#endif
+
+#define HOST_NUM_PIAS (sizeof(HostPIAs)/sizeof(HostPIAs[0]))
+
+static HostPIA *HostFindPIA(unsigned int address, byte *reg) {
+  for (unsigned int count=0; count<HOST_NUM_PIAS; count++) {
+    if ((address & ~0x0003)==HostPIAs[count]->base) {
+      *reg = address & 0x03;
+      return HostPIAs[count];
+    }
+  }
+  return NULL;
+}
+
+static boolean HostIRQAsserted() {
+#if (RPU_MPU_ARCHITECTURE<10)
+  for (unsigned int count=0; count<HOST_NUM_PIAS; count++) {
+    if (PIAIRQ(HostPIAs[count])) return true;
+  }
+#endif
+  return false;
+}
+
+
+/******************************************************
+ *   Bus decode (VMA edges on PG1)
+ */
+static HostBusCounters &HostCountersFor(unsigned int address) {
+  return HostAddressCounters[address];
+}
+
+static void HostBusCycleStart() {
+  unsigned int address = (PORTK.Peek()<<8) | PORTF.Peek();
+  boolean readCycle = (PORTE.Peek() & 0x20) ? true : false;
+  byte reg;
+  HostPIA *pia = HostFindPIA(address, &reg);
+
+  HostCycles += HOST_CALL_OVERHEAD;
+  HostBusWork += HOST_CALL_OVERHEAD;
+  HostCurrentAddress = address;
+  HostSection = (CurrentBusSection<HOST_NUM_SECTIONS) ? CurrentBusSection : 0;
+
+  // While the board's power-on reset is held, the PIAs ignore the bus
+  // and a read sees whatever was last on the data lines
+  boolean inReset = (HostCycles<HostBoardResetEnd) ? true : false;
+  if (inReset) pia = NULL;
+
+  if (readCycle) {
+    HostDataIn = pia ? PIARead(pia, reg) : (inReset ? HostLastBusData : 0xFF);
+    HostLastBusData = HostDataIn;
+    HostCountersFor(address).reads += 1;
+    HostSectionCounters[HostSection].reads += 1;
+    HostTotalReads += 1;
+  } else {
+    if (pia) PIAWrite(pia, reg, PORTA.Peek());
+    HostLastBusData = PORTA.Peek();
+    HostCountersFor(address).writes += 1;
+    HostSectionCounters[HostSection].writes += 1;
+    HostTotalWrites += 1;
+  }
+}
+
+static void HostBusCycleEnd() {
+  unsigned long long cycles = HostBusWork - HostBusWorkAtLastEnd;
+  HostCountersFor(HostCurrentAddress).cycles += cycles;
+  HostSectionCounters[HostSection].cycles += cycles;
+  HostBusWorkAtLastEnd = HostBusWork;
+}
+
+static byte HostReadPin(byte port) {
+  if (port==HP_A) return DDRA.Peek() ? PORTA.Peek() : HostDataIn;
+  if (port==HP_G) {
+    byte value = PORTG.Peek() & ~0x04;
+    if (DDRG.Peek() & 0x04) value |= PORTG.Peek() & 0x04;
+    else if (!HostMPUClock) value |= 0x04;
+    else if (((HostCycles * 2 * HOST_E_CLOCK_HZ) / HOST_CPU_HZ) & 1) value |= 0x04;
+    return value;
+  }
+  return HostPorts[port]->Peek();
+}
+
+HostRegister::operator byte() {
+  if ((id%3)==HOST_PIN) {
+    HostCycles += 4;
+    HostBusWork += 4;
+    return HostReadPin(id/3);
+  }
+  HostCycles += 1;
+  HostBusWork += 1;
+  return value;
+}
+
+HostRegister &HostRegister::operator=(byte newValue) {
+  byte oldValue = value;
+  value = newValue;
+  HostCycles += 2;
+  HostBusWork += 2;
+  if (this==&PORTG) {
+    if (!(oldValue & 0x02) && (newValue & 0x02)) HostBusCycleStart();
+    else if ((oldValue & 0x02) && !(newValue & 0x02)) HostBusCycleEnd();
+  }
+  return *this;
+}
+
+
+/******************************************************
+ *   Timers 1 & 2 and interrupts
+ */
+static unsigned long HostTimerPrescale(byte timer) {
+  if (timer==0) {
+    switch (TCCR1B & 0x07) {
+      case 1: return 1;
+      case 2: return 8;
+      case 3: return 64;
+      case 4: return 256;
+      case 5: return 1024;
+    }
+  } else {
+    switch (TCCR2B & 0x07) {
+      case 1: return 1;
+      case 2: return 8;
+      case 3: return 32;
+      case 4: return 64;
+      case 5: return 128;
+      case 6: return 256;
+      case 7: return 1024;
+    }
+  }
+  return 0;
+}
+
+static unsigned long HostTimerTop(byte timer) {
+  return (timer==0) ? ((unsigned long)OCR1A + 1) : ((unsigned long)OCR2A + 1);
+}
+
+static unsigned long long HostTimerPeriod(byte timer) {
+  return (unsigned long long)HostTimerPrescale(timer) * HostTimerTop(timer);
+}
+
+static boolean HostTimerRunning(byte timer) {
+  if (timer==0) return (TIMSK1 & (1<<OCIE1A)) && HostTimerPrescale(0);
+  return (TIMSK2 & (1<<OCIE2A)) && HostTimerPrescale(1) && TIMER2_COMPA_vect;
+}
+
+HostTimerCounter::operator uint16_t() {
+  HostCycles += 2;
+  if (timer==0) return (uint16_t)((HostCycles/64) & 0xFF);
+  byte index = timer-1;
+  if (!HostTimerPrescale(index)) return 0;
+  return (uint16_t)(((HostCycles - HostTimerStart[index]) / HostTimerPrescale(index)) % HostTimerTop(index));
+}
+
+HostTimerCounter &HostTimerCounter::operator=(uint16_t newValue) {
+  (void)newValue;
+  HostCycles += 2;
+  if (timer==0) return *this;
+  byte index = timer-1;
+  HostTimerStart[index] = HostCycles;
+  HostNextTimer[index] = 0;
+  HostTimerPending[index] = false;
+  return *this;
+}
+
+static void HostUpdateEvents() {
+  for (byte timer=0; timer<2; timer++) {
+    if (!HostTimerRunning(timer)) {
+      HostNextTimer[timer] = 0;
+      continue;
+    }
+    if (HostNextTimer[timer]==0) HostNextTimer[timer] = HostCycles + HostTimerPeriod(timer);
+    while (HostCycles>=HostNextTimer[timer]) {
+      if (!HostTimerPending[timer]) HostTimerDue[timer] = HostNextTimer[timer];
+      HostTimerPending[timer] = true;
+      HostNextTimer[timer] += HostTimerPeriod(timer);
+    }
+  }
+#if (RPU_MPU_ARCHITECTURE<10)
+  while (HostCycles>=HostNextZeroCross) {
+    HostZeroCrossing();
+    HostNextZeroCross += HOST_CPU_HZ/HOST_ZERO_CROSS_HZ;
+  }
+  while (HostCycles>=HostNextU11Display) {
+    HostU11.cra |= 0x80;
+    HostNextU11Display += HOST_CPU_HZ/HOST_U11_DISPLAY_HZ;
+  }
+#endif
+}
+
+static unsigned long long HostNextEvent() {
+  unsigned long long next = ~0ULL;
+  for (byte timer=0; timer<2; timer++) {
+    if (HostTimerRunning(timer) && HostNextTimer[timer] && HostNextTimer[timer]<next) next = HostNextTimer[timer];
+  }
+#if (RPU_MPU_ARCHITECTURE<10)
+  if (HostNextZeroCross<next) next = HostNextZeroCross;
+  if (HostNextU11Display<next) next = HostNextU11Display;
+#endif
+  return next;
+}
+
+static void HostCallISR(void (*isr)(void), HostISRCounters *counters, unsigned long long dueCycles) {
+  unsigned long long start = HostCycles;
+  unsigned long startReads = HostTotalReads, startWrites = HostTotalWrites;
+
+  if (start>dueCycles) {
+    counters->lateEntries += 1;
+    if ((start-dueCycles)>counters->maxLateCycles) counters->maxLateCycles = (unsigned long)(start-dueCycles);
+  }
+  if (HostISRDepth==0) HostBusyStart = start;
+  HostISRDepth += 1;
+  HostInterruptsEnabled = false;
+  isr();
+  HostISRDepth -= 1;
+
+  unsigned long long cycles = HostCycles - start;
+  counters->calls += 1;
+  counters->cycles += cycles;
+  if (cycles>counters->maxCycles) counters->maxCycles = (unsigned long)cycles;
+  counters->reads += HostTotalReads - startReads;
+  counters->writes += HostTotalWrites - startWrites;
+  if (HostISRDepth==0) HostISRBusyCycles += HostCycles - HostBusyStart;
+
+#if (RPU_MPU_ARCHITECTURE>=10)
+  if (isr==TIMER1_COMPA_vect) HostSampleSolenoids();
+#endif
+  // reti
+  HostInterruptsEnabled = true;
+}
+
+static void HostServiceInterrupts() {
+  byte irqRetries = 0;
+  HostUpdateEvents();
+  while (HostInterruptsEnabled) {
+    if (HostAttachedISR && HostIRQAsserted() && HostISRDepth<4 && irqRetries<2) {
+      irqRetries += 1;
+      HostCallISR(HostAttachedISR, &HostIRQCounters, HostCycles);
+    } else if (HostTimerPending[1] && HostTimerRunning(1)) {
+      // (AVR priority: INT0, then timer 2, then timer 1)
+      HostTimerPending[1] = false;
+      HostCallISR(TIMER2_COMPA_vect, &HostTimer2ISRCounters, HostTimerDue[1]);
+    } else if (HostTimerPending[0]) {
+      HostTimerPending[0] = false;
+      HostCallISR(TIMER1_COMPA_vect, &HostTimerISRCounters, HostTimerDue[0]);
+    } else {
+      break;
+    }
+    HostUpdateEvents();
+  }
+}
+
+void cli() {
+  HostInterruptsEnabled = false;
+}
+
+void sei() {
+  HostInterruptsEnabled = true;
+  HostServiceInterrupts();
+}
+
+HostStatusRegister::operator byte() {
+  return HostInterruptsEnabled ? 0x80 : 0x00;
+}
+
+HostStatusRegister &HostStatusRegister::operator=(byte newValue) {
+  if (newValue & 0x80) sei();
+  else cli();
+  return *this;
+}
+
+void attachInterrupt(int interruptNum, void (*handler)(void), int mode) {
+  (void)interruptNum; (void)mode;
+  HostAttachedISR = handler;
+}
+
+
+/******************************************************
+ *   Time
+ */
+unsigned long millis() {
+  return (unsigned long)(HostCycles / (HOST_CPU_HZ/1000));
+}
+
+unsigned long micros() {
+  return (unsigned long)(HostCycles / (HOST_CPU_HZ/1000000));
+}
+
+static void HostAdvance(unsigned long long cycles) {
+  unsigned long long target = HostCycles + cycles;
+  while (HostInterruptsEnabled && HostNextEvent()<target) {
+    if (HostCycles<HostNextEvent()) HostCycles = HostNextEvent();
+    HostServiceInterrupts();
+  }
+  if (HostCycles<target) HostCycles = target;
+}
+
+void delay(unsigned long ms) {
+  HostAdvance((unsigned long long)ms * (HOST_CPU_HZ/1000));
+}
+
+void delayMicroseconds(unsigned int us) {
+  // Busy loop - time spent in interrupts stretches it
+  HostAdvance((unsigned long long)us * (HOST_CPU_HZ/1000000));
+}
+
+
+/******************************************************
+ *   Pins
+ */
+struct HostPinMap { byte pin; byte port; byte bit; };
+static const HostPinMap HostPinMaps[] = {
+  {3, HP_E, 0x20}, {39, HP_G, 0x04}, {40, HP_G, 0x02}, {41, HP_G, 0x01},
+};
+
+static const HostPinMap *HostFindPin(byte pin) {
+  for (unsigned int count=0; count<sizeof(HostPinMaps)/sizeof(HostPinMaps[0]); count++) {
+    if (HostPinMaps[count].pin==pin) return &HostPinMaps[count];
+  }
+  return NULL;
+}
+
+void pinMode(byte pin, byte mode) {
+  const HostPinMap *map = HostFindPin(pin);
+  if (pin>=22 && pin<30) {
+    if (mode==OUTPUT) DDRA |= (1<<(pin-22));
+    else DDRA &= ~(1<<(pin-22));
+  } else if (map) {
+    if (mode==OUTPUT) *HostDDRs[map->port] |= map->bit;
+    else *HostDDRs[map->port] &= ~map->bit;
+  }
+}
+
+void digitalWrite(byte pin, byte value) {
+  const HostPinMap *map = HostFindPin(pin);
+  if (map) {
+    if (value) *HostPorts[map->port] |= map->bit;
+    else *HostPorts[map->port] &= ~map->bit;
+  }
+}
+
+int digitalRead(byte pin) {
+  if (pin==38) return HostSelectorSwitch ? 1 : 0;
+  return 0;
+}
+
+
+/******************************************************
+ *   Serial
+ */
+void HostSetSerialOutput(FILE *out) {
+  HostSerialOut = out;
+}
+
+size_t HostSerial::write(byte value) {
+  fputc(value, HostSerialOut ? HostSerialOut : stderr);
+  return 1;
+}
+
+size_t HostSerial::write(const char *text) {
+  fputs(text, HostSerialOut ? HostSerialOut : stderr);
+  return strlen(text);
+}
+
+size_t HostSerial::write(const byte *buffer, size_t length) {
+  fwrite(buffer, 1, length, HostSerialOut ? HostSerialOut : stderr);
+  return length;
+}
+
+int HostSerial::available() {
+  return 0;
+}
+
+int HostSerial::read() {
+  return -1;
+}
+
+
+/******************************************************
+ *   Harness API
+ */
+void HostPowerOn(boolean mpuClockPresent, boolean selectorSwitchClosed, unsigned long boardResetMicros) {
+  HostMPUClock = mpuClockPresent;
+  HostBoardResetEnd = HostCycles + (unsigned long long)boardResetMicros * (HOST_CPU_HZ/1000000);
+  HostSelectorSwitch = selectorSwitchClosed;
+  HostNextZeroCross = HOST_CPU_HZ/HOST_ZERO_CROSS_HZ;
+  HostNextU11Display = HOST_CPU_HZ/HOST_U11_DISPLAY_HZ;
+}
+
+void HostSetSwitch(byte switchNum, boolean closed) {
+  if (switchNum>=64) return;
+  if (closed) HostSwitchMatrix[switchNum/8] |= (1<<(switchNum%8));
+  else HostSwitchMatrix[switchNum/8] &= ~(1<<(switchNum%8));
+}
+
+void HostPressSelfTest() {
+#if (RPU_MPU_ARCHITECTURE<10)
+  HostU10.cra |= 0x80;
+#else
+  HostDisplayPIA.cra |= 0x80;
+#endif
+}
+
+#if (RPU_MPU_ARCHITECTURE>=10)
+void HostPressUpDown() {
+  HostDisplayPIA.crb |= 0x80;
+}
+#endif
+
+void HostRun(unsigned long microseconds, void (*mainLoop)(), unsigned long mainLoopMicros) {
+  unsigned long long end = HostCycles + (unsigned long long)microseconds * (HOST_CPU_HZ/1000000);
+  unsigned long long loopWork = (unsigned long long)(mainLoopMicros ? mainLoopMicros : 1) * (HOST_CPU_HZ/1000000);
+  unsigned long long loopLeft = loopWork;
+
+  HostInterruptsEnabled = true;
+  while (HostCycles<end) {
+    HostServiceInterrupts();
+    unsigned long long next = HostNextEvent();
+    if (next>end) next = end;
+    if (next<=HostCycles) next = HostCycles + 1;
+    if (mainLoop) {
+      unsigned long long slice = next - HostCycles;
+      if (slice>loopLeft) slice = loopLeft;
+      HostCycles += slice;
+      loopLeft -= slice;
+      if (loopLeft==0) {
+        mainLoop();
+        HostMainLoopIterations += 1;
+        loopLeft = loopWork;
+      }
+    } else {
+      HostCycles = next;
+    }
+  }
+}
+
+byte HostShownDigit(byte displayNum, byte digitNum) {
+#if (RPU_MPU_ARCHITECTURE<10)
+  if (displayNum>=5 || digitNum>=8) return 0xFF;
+#else
+  if (displayNum>=2 || digitNum>=16) return 0xFF;
+#endif
+  return HostDisplayShown[displayNum][digitNum];
+}
+
+#if (RPU_MPU_ARCHITECTURE==15)
+unsigned short HostShownAlpha(byte displayNum, byte digitNum) {
+  if (displayNum>=2 || digitNum>=7) return 0;
+  return HostAlphaShown[displayNum*8 + digitNum + 1];
+}
+#endif
+
+unsigned long HostLampOnSamples(byte lampNum) {
+  return (lampNum<HOST_MAX_LAMPS) ? HostLampOn[lampNum] : 0;
+}
+
+unsigned long HostLampSamples() {
+  return HostLampSampleCount;
+}
+
+unsigned long HostSolenoidFires(byte solNum) {
+  return (solNum<HOST_MAX_SOLENOIDS) ? HostSolFires[solNum] : 0;
+}
+
+unsigned long HostSolenoidLastFireMicros(byte solNum) {
+  return (solNum<HOST_MAX_SOLENOIDS) ? (unsigned long)(HostSolFireCycle[solNum]/(HOST_CPU_HZ/1000000)) : 0;
+}
+
+unsigned long HostSoundCommands() {
+  return HostSoundCmds;
+}
+
+unsigned long HostSoundCommandPasses() {
+  return HostSoundCmdPasses;
+}
+
+byte HostMaxSolenoidsOn() {
+  return HostMaxSolsOn;
+}
+
+unsigned long HostSolenoidOnSamples(byte solNum) {
+  return (solNum<HOST_MAX_SOLENOIDS) ? HostSolOn[solNum] : 0;
+}
+
+void HostResetStats() {
+  HostAddressCounters.clear();
+  memset(HostSectionCounters, 0, sizeof(HostSectionCounters));
+  memset(&HostTimerISRCounters, 0, sizeof(HostTimerISRCounters));
+  memset(&HostTimer2ISRCounters, 0, sizeof(HostTimer2ISRCounters));
+  memset(&HostIRQCounters, 0, sizeof(HostIRQCounters));
+  memset(HostLampOn, 0, sizeof(HostLampOn));
+  memset(HostSolFires, 0, sizeof(HostSolFires));
+  memset(HostSolOn, 0, sizeof(HostSolOn));
+  HostLampSampleCount = 0;
+  HostISRBusyCycles = 0;
+  HostMainLoopIterations = 0;
+  HostMinSettleCycles = ~0ULL;
+  HostLastDisplayStrobe = 0;
+  HostMaxSolsOn = 0;
+  HostSoundCmds = 0;
+  HostSoundCmdPasses = 0;
+  HostDisplayStrobeMin = ~0ULL;
+  HostDisplayStrobeMax = 0;
+  HostDisplayStrobeTotal = 0;
+  HostDisplayStrobes = 0;
+  HostStatsStart = HostCycles;
+}
+
+static void HostPrintISR(FILE *out, const char *name, HostISRCounters *counters) {
+  if (!counters->calls) return;
+  fprintf(out, "  %-14s calls %7lu  avg %7.1f cyc  max %7lu cyc  bus/call %6.1f (%5.1f rd, %5.1f wr)  late %lu (max %lu cyc)\n",
+          name, counters->calls, (double)counters->cycles/counters->calls, counters->maxCycles,
+          (double)(counters->reads+counters->writes)/counters->calls,
+          (double)counters->reads/counters->calls, (double)counters->writes/counters->calls,
+          counters->lateEntries, counters->maxLateCycles);
+}
+
+void HostPrintReport(FILE *out, const char *title) {
+  // In RPU_BUS_SECTION_* order
+  static const char *sectionNames[HOST_NUM_SECTIONS] = {"other", "display", "switches", "solenoids", "lamps", "sound", "irq-check", "init"};
+  unsigned long long elapsed = HostCycles - HostStatsStart;
+
+  fprintf(out, "== %s ==\n", title);
+  fprintf(out, "  virtual time %.3f s, interrupt busy %.2f%%, main loop passes %lu\n",
+          (double)elapsed/HOST_CPU_HZ, elapsed ? 100.0*(double)HostISRBusyCycles/(double)elapsed : 0.0, HostMainLoopIterations);
+  HostPrintISR(out, "TIMER1_COMPA", &HostTimerISRCounters);
+  HostPrintISR(out, "TIMER2_COMPA", &HostTimer2ISRCounters);
+  HostPrintISR(out, "IRQ", &HostIRQCounters);
+  if (HostMinSettleCycles!=~0ULL) fprintf(out, "  min switch strobe-to-read %.1f us\n", (double)HostMinSettleCycles/(HOST_CPU_HZ/1000000));
+  if (HostDisplayStrobes) {
+    fprintf(out, "  display strobe period avg %.2f us, min %.2f us, max %.2f us (jitter %.2f us)\n",
+            (double)HostDisplayStrobeTotal/HostDisplayStrobes/(HOST_CPU_HZ/1000000),
+            (double)HostDisplayStrobeMin/(HOST_CPU_HZ/1000000), (double)HostDisplayStrobeMax/(HOST_CPU_HZ/1000000),
+            (double)(HostDisplayStrobeMax-HostDisplayStrobeMin)/(HOST_CPU_HZ/1000000));
+  }
+
+  fprintf(out, "  section       reads     writes        cycles\n");
+  for (byte section=0; section<HOST_NUM_SECTIONS; section++) {
+    HostBusCounters *c = &HostSectionCounters[section];
+    if (!c->reads && !c->writes) continue;
+    fprintf(out, "  %-10s %8lu %10lu %13llu\n", sectionNames[section], c->reads, c->writes, c->cycles);
+  }
+  fprintf(out, "  address       reads     writes        cycles\n");
+  for (std::map<unsigned int, HostBusCounters>::iterator it=HostAddressCounters.begin(); it!=HostAddressCounters.end(); ++it) {
+    fprintf(out, "  0x%04X     %8lu %10lu %13llu\n", it->first, it->second.reads, it->second.writes, it->second.cycles);
+  }
+}
@@ -0,0 +1,85 @@
+/**************************************************************************
+ *   Emulated MPU board for host builds of RPU.cpp
+ *
+ *   The emulator watches the Arduino port registers the same way the MPU
+ *   board does (VMA rising edge latches address, R/W and data) and routes
+ *   each bus cycle to a software MC6821 model. Time is virtual: port
+ *   accesses, bus waits and delay calls advance HostCycles (16 MHz).
+ */
+#ifndef HOST_BUS_H
+#define HOST_BUS_H
+
+#include "Arduino.h"
+
+#define HOST_CPU_HZ             16000000UL
+#define HOST_NUM_SECTIONS       8
+#define HOST_MAX_LAMPS          128
+#define HOST_MAX_SOLENOIDS      24
+
+struct HostBusCounters {
+  unsigned long reads;
+  unsigned long writes;
+  unsigned long long cycles;
+};
+
+struct HostISRCounters {
+  unsigned long calls;
+  unsigned long long cycles;
+  unsigned long maxCycles;
+  unsigned long reads;
+  unsigned long writes;
+  unsigned long lateEntries;
+  unsigned long maxLateCycles;
+};
+
+extern unsigned long long HostCycles;
+extern HostBusCounters HostSectionCounters[HOST_NUM_SECTIONS];
+extern HostISRCounters HostTimerISRCounters;
+extern HostISRCounters HostTimer2ISRCounters;
+extern HostISRCounters HostIRQCounters;
+extern unsigned long long HostISRBusyCycles;
+extern unsigned long HostMainLoopIterations;
+
+// Board setup (the PIAs don't respond until the board's power-on
+// reset is over)
+void HostPowerOn(boolean mpuClockPresent, boolean selectorSwitchClosed, unsigned long boardResetMicros = 0);
+
+// Playfield stimulus
+void HostSetSwitch(byte switchNum, boolean closed);
+void HostPressSelfTest();
+#if (RPU_MPU_ARCHITECTURE>=10)
+// (the coin door up/down switch, on the display PIA's CB1)
+void HostPressUpDown();
+#endif
+
+// Virtual clock: runs interrupts (and the main loop, if given) for the
+// requested time. The main loop is modeled as a fixed amount of work per
+// pass that is preempted by the interrupts.
+void HostRun(unsigned long microseconds, void (*mainLoop)() = NULL, unsigned long mainLoopMicros = 0);
+
+// Observed outputs
+byte HostShownDigit(byte displayNum, byte digitNum);
+#if (RPU_MPU_ARCHITECTURE==15)
+// (port A in the high byte, port B in the low byte)
+unsigned short HostShownAlpha(byte displayNum, byte digitNum);
+#endif
+unsigned long HostLampOnSamples(byte lampNum);
+unsigned long HostLampSamples();
+unsigned long HostSolenoidFires(byte solNum);
+unsigned long HostSolenoidOnSamples(byte solNum);
+// (micros() when it last came on, and the most coils seen on at once)
+unsigned long HostSolenoidLastFireMicros(byte solNum);
+byte HostMaxSolenoidsOn();
+// Sounds sent out the W-type 2 sound port, and how many solenoid
+// passes they were held for in all
+unsigned long HostSoundCommands();
+unsigned long HostSoundCommandPasses();
+
+// Where Serial output goes (stderr by default)
+void HostSetSerialOutput(FILE *out);
+
+// Statistics
+void HostResetStats();
+void HostPrintReport(FILE *out, const char *title);
+
+#endif
@@ -0,0 +1,443 @@
+/**************************************************************************
+ *   Host benchmark driver for RPU.cpp
+ */
+#include "Arduino.h"
+#include "RPU_Config.h"
+#include "RPU.h"
+#include "HostBus.h"
+
+// How long the MPU board's power-on reset keeps the PIAs from answering
+#define HOST_BOARD_RESET_MICROS   60000UL
+// Lamps 32-47 are set to brightness 0-15 in the attract scene
+#define HOST_BRIGHTNESS_RAMP_LAMP 32
+
+#if (RPU_MPU_ARCHITECTURE<10)
+#define HOST_CREDIT_RESET_SWITCH  5
+#else
+#define HOST_CREDIT_RESET_SWITCH  2
+#endif
+
+// (architecture detection needs a Rev 101 or later board)
+#if (RPU_OS_HARDWARE_REV>=101)
+#define HOST_INIT_OPTIONS (RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_SWITCH_CLOSED | RPU_CMD_PERFORM_MPU_TEST | RPU_CMD_AUTODETECT_ARCHITECTURE)
+#else
+#define HOST_INIT_OPTIONS (RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_SWITCH_CLOSED | RPU_CMD_PERFORM_MPU_TEST)
+#endif
+
+// Switch scene: each main loop pass is a fixed amount of work and then
+// RPU_Update & the switch stack, while a switch is pressed and released
+// over and over (at times that drift against the interrupts)
+#define HOST_MAIN_LOOP_MICROS       100
+#define HOST_LATENCY_SWITCH         20
+#define HOST_LATENCY_PRESSES        40
+
+#define HOST_LATENCY_SOLENOID       6
+
+// Debounce scene: a drop target that rebounds off its switch once per
+// hit (closed 30 ms, open 25 ms, closed 30 ms). Its opens are reported
+// too, and there shouldn't be more of them than closures.
+#define HOST_BOUNCE_SWITCH          21
+#define HOST_BOUNCE_HITS            20
+#define HOST_BOUNCE_RETRIGGER_MS    80
+
+// Spinner scene: while the main loop is stuck in something else, a
+// spinner (sampled with a 1-sample debounce) closes every 20 ms and
+// then a coin comes in
+#define HOST_SPINNER_SWITCH         22
+#define HOST_SPINNER_CLOSURES       80
+#define HOST_COIN_SWITCH            23
+
+// The pressed switch is a sling (a priority switch), at the end of
+// a game switch table the size of a real game's
+PlayfieldAndCabinetSwitch HostGameSwitches[] = {
+  {33, 1, 4}, {34, 2, 4}, {35, 3, 4}, {36, 4, 4}, {37, 5, 4}, {38, 7, 4},
+  {HOST_LATENCY_SWITCH, HOST_LATENCY_SOLENOID, 4},
+  {8, 9, 4}, {24, SOL_NONE, 0}, {25, 10, 2}, {26, 11, 2}
+};
+#define HOST_NUM_GAME_SWITCHES           (sizeof(HostGameSwitches)/sizeof(PlayfieldAndCabinetSwitch))
+#define HOST_NUM_PRIORITY_GAME_SWITCHES  7
+
+// What the library measured itself (only with RPU_OS_USE_ISR_STATS),
+// to check against the report
+static void PrintISRStats() {
+#ifdef RPU_OS_USE_ISR_STATS
+  RPUISRStats stats;
+  RPU_GetISRStats(&stats);
+  const char *isrNames[RPU_NUM_ISRS] = {"timer", "switch scan", "IRQ"};
+  printf("  RPU_GetISRStats:");
+  for (byte isr=0; isr<RPU_NUM_ISRS; isr++) {
+    if (stats.calls[isr]==0) continue;
+    printf(" %s %lu calls avg %u max %u us,", isrNames[isr], stats.calls[isr], stats.averageMicros[isr], stats.maxMicros[isr]);
+  }
+  printf(" timer late by up to %u us, masked up to %u us, %lu skipped crossings\n",
+         stats.maxTimerLateMicros, stats.maxMaskedMicros, stats.skippedZeroCrossings);
+#if (RPU_MPU_ARCHITECTURE>=10)
+  printf("  timer worst case by slot:");
+  for (byte slot=0; slot<RPU_MAX_TIMER_SLOTS; slot++) {
+    if (stats.maxTimerSlotMicros[slot]) printf(" %u us", stats.maxTimerSlotMicros[slot]);
+  }
+  printf("\n");
+#endif
+#endif
+}
+
+static unsigned long LatencyPressTime = 0;
+static boolean LatencyWaiting = false;
+static unsigned long LatencyTotal = 0, LatencyMax = 0, LatencyCount = 0;
+static unsigned long DetectedTotal = 0, DetectedMax = 0, PulledTotal = 0, PulledMax = 0;
+static unsigned long ReleaseTime = 0;
+static boolean ReleaseWaiting = false;
+static unsigned long ReleaseTotal = 0, ReleaseMax = 0, ReleaseCount = 0;
+static unsigned long BounceClosures = 0, BounceOpens = 0;
+static unsigned long SpinnerClosures = 0, CoinClosures = 0;
+
+static void HostMainLoop() {
+  RPU_Update(millis());
+  RPUSwitchEvent switchEvent;
+  while (RPU_PullFirstSwitchEvent(&switchEvent)) {
+    byte switchHit = switchEvent.switchNum;
+    if (switchEvent.edge==RPU_SWITCH_EDGE_OPENED) {
+      if (switchHit==HOST_BOUNCE_SWITCH) BounceOpens += 1;
+      if (switchHit!=HOST_LATENCY_SWITCH || !ReleaseWaiting) continue;
+      unsigned long release = micros() - ReleaseTime;
+      ReleaseTotal += release;
+      if (release>ReleaseMax) ReleaseMax = release;
+      ReleaseCount += 1;
+      ReleaseWaiting = false;
+      continue;
+    }
+    if (switchHit==HOST_BOUNCE_SWITCH) BounceClosures += 1;
+    if (switchHit==HOST_SPINNER_SWITCH) SpinnerClosures += switchEvent.count;
+    if (switchHit==HOST_COIN_SWITCH) CoinClosures += 1;
+#if (RPU_MPU_ARCHITECTURE>=10)
+    // (Arch 1 fires it from the ISR, through the game switch table)
+    if (switchHit==HOST_LATENCY_SWITCH) RPU_PushToSolenoidStack(HOST_LATENCY_SOLENOID, 4);
+#endif
+    if (switchHit!=HOST_LATENCY_SWITCH || !LatencyWaiting) continue;
+    unsigned long latency = micros() - LatencyPressTime;
+    LatencyTotal += latency;
+    if (latency>LatencyMax) LatencyMax = latency;
+    LatencyCount += 1;
+    // Split at the time stamp the interrupt put on it
+    unsigned long detected = switchEvent.detectedMicros - LatencyPressTime;
+    unsigned long pulled = micros() - switchEvent.detectedMicros;
+    DetectedTotal += detected;
+    if (detected>DetectedMax) DetectedMax = detected;
+    PulledTotal += pulled;
+    if (pulled>PulledMax) PulledMax = pulled;
+    LatencyWaiting = false;
+  }
+}
+
+static void RunSwitchScene() {
+  RPU_SetupGameSwitches(HOST_NUM_GAME_SWITCHES, HOST_NUM_PRIORITY_GAME_SWITCHES, HostGameSwitches);
+  RPU_SetSwitchOpenEvents(HOST_LATENCY_SWITCH);
+  HostResetStats();
+  RPU_ResetISRStats();
+  unsigned long long sceneStart = HostCycles;
+  for (byte press=0; press<HOST_LATENCY_PRESSES; press++) {
+    HostSetSwitch(HOST_LATENCY_SWITCH, true);
+    LatencyPressTime = micros();
+    LatencyWaiting = true;
+    HostRun(37000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+    HostSetSwitch(HOST_LATENCY_SWITCH, false);
+    ReleaseTime = micros();
+    ReleaseWaiting = true;
+    HostRun(29000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+  }
+  HostPrintReport(stdout, "switch scene");
+  PrintISRStats();
+  printf("  main loop passes per second %.0f (%d us of work each)\n", HostMainLoopIterations/((double)(HostCycles-sceneStart)/HOST_CPU_HZ), HOST_MAIN_LOOP_MICROS);
+  printf("  switch latency (press to RPU_PullFirstSwitchEvent): %lu of %d seen, avg %lu us, max %lu us\n",
+         LatencyCount, HOST_LATENCY_PRESSES, LatencyCount ? LatencyTotal/LatencyCount : 0, LatencyMax);
+  printf("    press to detected in the interrupt avg %lu us, max %lu us; detected to pulled avg %lu us, max %lu us\n",
+         LatencyCount ? DetectedTotal/LatencyCount : 0, DetectedMax, LatencyCount ? PulledTotal/LatencyCount : 0, PulledMax);
+  printf("  release to open event (RPU_SetSwitchOpenEvents): %lu of %d seen, avg %lu us, max %lu us\n",
+         ReleaseCount, HOST_LATENCY_PRESSES, ReleaseCount ? ReleaseTotal/ReleaseCount : 0, ReleaseMax);
+  printf("  sling solenoid %d fired %lu times\n", HOST_LATENCY_SOLENOID, HostSolenoidFires(HOST_LATENCY_SOLENOID));
+  RPU_SetSwitchOpenEvents(HOST_LATENCY_SWITCH, false);
+  RPU_SetupGameSwitches(0, 0, NULL);
+}
+
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+static void RunDebounceScene() {
+  const char *names[2] = {"default debounce", "80 ms retrigger"};
+  RPU_SetSwitchOpenEvents(HOST_BOUNCE_SWITCH);
+  for (byte setup=0; setup<2; setup++) {
+    RPU_SetSwitchDebounce(HOST_BOUNCE_SWITCH, 2, 2, setup ? HOST_BOUNCE_RETRIGGER_MS : 0);
+    BounceClosures = 0;
+    BounceOpens = 0;
+    for (byte hit=0; hit<HOST_BOUNCE_HITS; hit++) {
+      HostSetSwitch(HOST_BOUNCE_SWITCH, true);
+      HostRun(30000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+      HostSetSwitch(HOST_BOUNCE_SWITCH, false);
+      HostRun(25000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+      HostSetSwitch(HOST_BOUNCE_SWITCH, true);
+      HostRun(30000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+      HostSetSwitch(HOST_BOUNCE_SWITCH, false);
+      HostRun(200000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+    }
+    printf("== debounce scene, %s ==\n", names[setup]);
+    printf("  %lu closures and %lu opens for %d hits%s\n", BounceClosures, BounceOpens, HOST_BOUNCE_HITS,
+           (BounceOpens>BounceClosures) ? " - MORE OPENS THAN CLOSURES" : "");
+  }
+  RPU_SetSwitchOpenEvents(HOST_BOUNCE_SWITCH, false);
+  RPU_SetSwitchDebounce(HOST_BOUNCE_SWITCH, 2, 2);
+}
+#endif
+
+static void RunSpinnerScene() {
+  const char *names[2] = {"each closure stacked", "coalesced"};
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  const byte numSetups = 2;
+#else
+  const byte numSetups = 1;
+#endif
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+  RPU_SetSwitchDebounce(HOST_SPINNER_SWITCH, 1, 1);
+#endif
+  for (byte setup=0; setup<numSetups; setup++) {
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+    RPU_SetSwitchCoalescing(HOST_SPINNER_SWITCH, setup ? true : false);
+#endif
+    SpinnerClosures = 0;
+    CoinClosures = 0;
+    for (byte spin=0; spin<HOST_SPINNER_CLOSURES; spin++) {
+      HostSetSwitch(HOST_SPINNER_SWITCH, true);
+      HostRun(10000);
+      HostSetSwitch(HOST_SPINNER_SWITCH, false);
+      HostRun(10000);
+    }
+    HostSetSwitch(HOST_COIN_SWITCH, true);
+    HostRun(40000);
+    HostSetSwitch(HOST_COIN_SWITCH, false);
+    HostRun(100000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+    printf("== spinner scene, %s ==\n", names[setup]);
+    printf("  %lu of %d spinner closures counted, coin %s\n", SpinnerClosures, HOST_SPINNER_CLOSURES, CoinClosures ? "seen" : "lost");
+  }
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  RPU_SetSwitchCoalescing(HOST_SPINNER_SWITCH, false);
+#endif
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+  RPU_SetSwitchDebounce(HOST_SPINNER_SWITCH, 2, 2);
+#endif
+}
+
+#if (RPU_MPU_ARCHITECTURE>=10)
+// Both slings hit at the same moment (each pushed for 4 passes), first
+// with the default budget of one coil at a time, then with a budget of
+// two but the coils in the same group, then able to fire together
+#define HOST_SECOND_SLING_SOLENOID  7
+#define HOST_SLING_PAIRS            20
+static void RunSolenoidScene() {
+  const char *names[3] = {"budget 1", "budget 2, same group", "budget 2, separate groups"};
+  for (byte setup=0; setup<3; setup++) {
+    RPU_SetSolenoidPowerBudget(setup ? 2 : 1);
+    RPU_SetSolenoidPower(HOST_LATENCY_SOLENOID, 1, (setup==1) ? 0x01 : 0x00);
+    RPU_SetSolenoidPower(HOST_SECOND_SLING_SOLENOID, 1, 0x01);
+    HostResetStats();
+    unsigned long delayTotal = 0, delayMax = 0;
+    for (byte pair=0; pair<HOST_SLING_PAIRS; pair++) {
+      RPU_PushToSolenoidStack(HOST_LATENCY_SOLENOID, 4);
+      RPU_PushToSolenoidStack(HOST_SECOND_SLING_SOLENOID, 4);
+      HostRun(30000);
+      unsigned long delay = HostSolenoidLastFireMicros(HOST_SECOND_SLING_SOLENOID) - HostSolenoidLastFireMicros(HOST_LATENCY_SOLENOID);
+      delayTotal += delay;
+      if (delay>delayMax) delayMax = delay;
+    }
+    printf("== solenoid scene, %s ==\n", names[setup]);
+    printf("  second sling on %lu us after the first (max %lu us), fired %lu and %lu times, up to %d coils on at once\n",
+           delayTotal/HOST_SLING_PAIRS, delayMax, HostSolenoidFires(HOST_LATENCY_SOLENOID), HostSolenoidFires(HOST_SECOND_SLING_SOLENOID),
+           HostMaxSolenoidsOn());
+  }
+  RPU_SetSolenoidPowerBudget(1);
+  RPU_SetSolenoidPower(HOST_LATENCY_SOLENOID, 1);
+  RPU_SetSolenoidPower(HOST_SECOND_SLING_SOLENOID, 1);
+}
+#endif
+
+#if (RPU_MPU_ARCHITECTURE>=10) && defined(RPU_OS_USE_ISR_STATS)
+// Every timer job at its worst at once: the coin door and up/down
+// interrupts waiting, a coil on a CA2/CB2 line and one on the ports
+// going on and off, and (with W-type 2 sound) a sound to send
+#define HOST_SLOT_TRIGGERED_SOLENOID  16
+#define HOST_SLOT_LOAD_PASSES         50
+static void RunTimerSlotScene() {
+  RPU_ResetISRStats();
+  for (byte pass=0; pass<HOST_SLOT_LOAD_PASSES; pass++) {
+    HostPressSelfTest();
+    HostPressUpDown();
+    RPU_PushToSolenoidStack(HOST_SLOT_TRIGGERED_SOLENOID, 1);
+    RPU_PushToSolenoidStack(HOST_LATENCY_SOLENOID, 1);
+#ifdef RPU_OS_USE_WTYPE_2_SOUND
+    RPU_PushToSoundStack(1, 1);
+#endif
+    HostRun(10000, HostMainLoop, HOST_MAIN_LOOP_MICROS);
+  }
+  printf("== timer slot scene ==\n");
+  PrintISRStats();
+}
+#endif
+
+#ifdef RPU_OS_USE_WTYPE_2_SOUND
+// Bursty scoring: 20 times, 12 different sounds are pushed (8 passes
+// each, as AudioHandler does) within 12 ms, and then left to play out
+#define HOST_SOUND_BURSTS           20
+#define HOST_SOUNDS_PER_BURST       12
+#define HOST_SOUND_PASSES           8
+static void RunSoundScene() {
+  HostResetStats();
+  for (byte burst=0; burst<HOST_SOUND_BURSTS; burst++) {
+    for (byte sound=1; sound<=HOST_SOUNDS_PER_BURST; sound++) {
+      RPU_PushToSoundStack(sound, HOST_SOUND_PASSES);
+      HostRun(1000);
+    }
+    HostRun(400000);
+  }
+  printf("== sound scene ==\n");
+  printf("  %lu of %d sounds played, held for %lu of %d passes\n",
+         HostSoundCommands(), HOST_SOUND_BURSTS*HOST_SOUNDS_PER_BURST,
+         HostSoundCommandPasses(), HOST_SOUND_BURSTS*HOST_SOUNDS_PER_BURST*HOST_SOUND_PASSES);
+}
+#endif
+
+#ifdef RPU_OS_ADAPTIVE_DISPLAY_REFRESH
+// Light main-loop work and then heavy (a busy multiball), with the
+// refresh allowed anywhere from 434 Hz (35) to 319 Hz (48)
+#define HOST_ADAPTIVE_FASTEST       35
+#define HOST_ADAPTIVE_SLOWEST       48
+#define HOST_ADAPTIVE_MIN_LOOPS     7200
+static void RunAdaptiveRefreshScene() {
+  const unsigned long loopMicros[2] = {100, 118};
+  const char *names[2] = {"light load", "heavy load"};
+  RPU_SetAdaptiveDisplayRefresh(HOST_ADAPTIVE_FASTEST, HOST_ADAPTIVE_SLOWEST, HOST_ADAPTIVE_MIN_LOOPS, 10);
+  for (byte load=0; load<2; load++) {
+    HostRun(4000000, HostMainLoop, loopMicros[load]);
+    HostMainLoopIterations = 0;
+    unsigned long long start = HostCycles;
+    HostRun(1000000, HostMainLoop, loopMicros[load]);
+    RPUISRStats stats;
+    RPU_GetISRStats(&stats);
+    printf("== adaptive refresh, %s (%lu us of work per loop) ==\n", names[load], loopMicros[load]);
+    printf("  refresh constant %u (%.1f Hz), %u changes so far, %.0f loops per second (target %d)\n",
+           stats.displayRefreshConstant, 16000000.0/1024/(stats.displayRefreshConstant+1), stats.displayRefreshChanges,
+           HostMainLoopIterations/((double)(HostCycles-start)/HOST_CPU_HZ), HOST_ADAPTIVE_MIN_LOOPS);
+  }
+  RPU_SetAdaptiveDisplayRefresh(0, 0, 0);
+}
+#endif
+
+static void SetUpAttractScene() {
+  for (int display=0; display<4; display++) RPU_SetDisplay(display, 123456UL*(display+1), true, 2);
+#if (RPU_MPU_ARCHITECTURE==15)
+  // Commas, a decimal point and a custom glyph (every segment lit)
+  RPU_SetDisplay(0, 1234567UL, true, 2, true);
+  RPU_SetDisplayText(1, (char *)"RPU 5.8", true, true);
+  RPU_SetDisplayGlyph(1, 6, 0x3FFF | RPU_GLYPH_DECIMAL | RPU_GLYPH_COMMA);
+  RPU_SetDisplayBlank(1, 0x7F);
+#endif
+  RPU_SetDisplayCredits(12, true);
+  RPU_SetDisplayBallInPlay(3, true);
+  for (int lamp=0; lamp<RPU_MAX_LAMPS; lamp++) {
+    RPU_SetLampState(lamp, (lamp%3)!=0, (lamp%5)==0 ? 1 : ((lamp%7)==0 ? 2 : 0));
+  }
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+  // A brightness ramp, 0 to 15
+  for (int lamp=HOST_BRIGHTNESS_RAMP_LAMP; lamp<HOST_BRIGHTNESS_RAMP_LAMP+16; lamp++) {
+    RPU_SetLampState(lamp, 1);
+    RPU_SetLampBrightness(lamp, lamp-HOST_BRIGHTNESS_RAMP_LAMP);
+  }
+#endif
+}
+
+static void PrintOutputs() {
+#if (RPU_MPU_ARCHITECTURE<10)
+  for (byte display=0; display<5; display++) {
+    printf("  display %d: ", display);
+    for (byte digit=0; digit<RPU_OS_NUM_DIGITS; digit++) {
+      byte value = HostShownDigit(display, digit);
+      printf("%c", value<10 ? '0'+value : '_');
+    }
+    printf("\n");
+  }
+#elif (RPU_MPU_ARCHITECTURE==15)
+  for (byte display=0; display<2; display++) {
+    printf("  alpha display %d:", display);
+    for (byte digit=0; digit<7; digit++) printf(" %04X", HostShownAlpha(display, digit));
+    printf("\n");
+  }
+#endif
+  printf("  lamp duty (%%):");
+  for (int lamp=0; lamp<RPU_MAX_LAMPS && lamp<24; lamp++) {
+    printf(" %lu", HostLampSamples() ? (100*HostLampOnSamples(lamp))/HostLampSamples() : 0);
+  }
+  printf("\n");
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+  printf("  brightness ramp duty (%%):");
+  for (int lamp=HOST_BRIGHTNESS_RAMP_LAMP; lamp<HOST_BRIGHTNESS_RAMP_LAMP+16; lamp++) {
+    printf(" %lu", HostLampSamples() ? (100*HostLampOnSamples(lamp))/HostLampSamples() : 0);
+  }
+  printf("\n");
+#endif
+}
+
+int main(int argc, char **argv) {
+  // Optional: file for the Serial output (a bus trace dump, when the
+  // build has RPU_OS_USE_BUS_TRACE)
+  FILE *serialOut = NULL;
+  if (argc>1) {
+    serialOut = fopen(argv[1], "wb");
+    if (serialOut==NULL) {
+      fprintf(stderr, "Can't open %s\n", argv[1]);
+      return 1;
+    }
+    HostSetSerialOutput(serialOut);
+  }
+
+  HostPowerOn(RPU_MPU_BUILD_FOR_6800 ? true : false, true, HOST_BOARD_RESET_MICROS);
+
+  unsigned long initResult = RPU_InitializeMPU(HOST_INIT_OPTIONS, HOST_CREDIT_RESET_SWITCH);
+  printf("RPU_InitializeMPU returned 0x%04lX at %lu ms (board reset held for %lu ms)\n", initResult, millis(), HOST_BOARD_RESET_MICROS/1000);
+  if (HOST_INIT_OPTIONS & RPU_CMD_AUTODETECT_ARCHITECTURE) printf("  detected architecture %d\n", RPU_GetDetectedArchitecture());
+  RPUBusTestResults busTest;
+  RPU_GetBusTestResults(&busTest);
+  printf("  bus test: read %u ns, write %u ns, stuck high 0x%02X, stuck low 0x%02X, shorted 0x%02X\n",
+         busTest.readNanoseconds, busTest.writeNanoseconds, busTest.stuckHighLines, busTest.stuckLowLines, busTest.shortedLines);
+  const char *bootPhaseNames[RPU_NUM_BOOT_PHASES] = {"clock check", "board ready", "boot select", "PIA setup", "PIA test", "interrupts"};
+  for (byte phase=0; phase<RPU_NUM_BOOT_PHASES; phase++) {
+    printf("  %-12s %7lu us\n", bootPhaseNames[phase], RPU_GetBootPhaseMicros(phase));
+  }
+
+  SetUpAttractScene();
+  HostRun(100000);
+  HostResetStats();
+  RPU_ResetISRStats();
+  HostRun(1000000);
+  HostPrintReport(stdout, "attract scene, 1 s");
+  PrintISRStats();
+  PrintOutputs();
+  RunSwitchScene();
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+  RunDebounceScene();
+#endif
+  RunSpinnerScene();
+#if (RPU_MPU_ARCHITECTURE>=10)
+  RunSolenoidScene();
+#endif
+#if (RPU_MPU_ARCHITECTURE>=10) && defined(RPU_OS_USE_ISR_STATS)
+  RunTimerSlotScene();
+#endif
+#ifdef RPU_OS_USE_WTYPE_2_SOUND
+  RunSoundScene();
+#endif
+#ifdef RPU_OS_ADAPTIVE_DISPLAY_REFRESH
+  RunAdaptiveRefreshScene();
+#endif
+
+#ifdef RPU_OS_USE_BUS_TRACE
+  RPU_DumpBusTrace();
+#endif
+  if (serialOut) fclose(serialOut);
+
+  return 0;
+}
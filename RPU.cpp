@@ -23,11 +23,25 @@
 #include <Arduino.h>
 #include <EEPROM.h>
 #define RPU_CPP_FILE
-#include "RPU_config.h"
+#include "RPU_Config.h"
 #include "RPU.h"
 
 #define DEBUG_MESSAGES  0
 
+// Marks which part of the code owns the bus cycles that follow
+// (see RPU_BUS_SECTION_* in RPU.h). Only kept when something uses it
+// (the bus trace, or a host build).
+#if defined(RPU_OS_USE_BUS_TRACE) || defined(RPU_OS_TRACK_BUS_SECTIONS)
+volatile byte CurrentBusSection = RPU_BUS_SECTION_OTHER;
+#define RPU_BUS_SECTION(section)    CurrentBusSection = (section)
+#define RPU_BUS_SECTION_SAVE()      byte lastBusSection = CurrentBusSection
+#define RPU_BUS_SECTION_RESTORE()   CurrentBusSection = lastBusSection
+#else
+#define RPU_BUS_SECTION(section)
+#define RPU_BUS_SECTION_SAVE()
+#define RPU_BUS_SECTION_RESTORE()
+#endif
+
 #ifndef RPU_OS_HARDWARE_REV
 #define RPU_OS_HARDWARE_REV 1
 #endif
@@ -45,11 +59,13 @@
  */
 #if !defined(RPU_MPU_BUILD_FOR_6800) || (RPU_MPU_BUILD_FOR_6800==1)
 boolean UsesM6800Processor = true;
+#define BUILT_FOR_M6800   true
 #if (RPU_MPU_ARCHITECTURE>11) && (RPU_OS_HARDWARE_REV<102)
 #error "Architecture > 11 doesn't make sense with RPU_MPU_BUILD_FOR_6800=1. Set RPU_MPU_BUILD_FOR_6800 to 0 in RPU_Config.h or choose a different RPU_MPU_ARCHITECTURE"
 #endif 
 #else
 boolean UsesM6800Processor = false;
+#define BUILT_FOR_M6800   false
 #endif 
 
 #if (RPU_MPU_ARCHITECTURE<10) 
@@ -100,7 +116,9 @@ volatile byte DisplayCommas;
 #endif
 
 #if (RPU_MPU_ARCHITECTURE == 15)
-volatile byte DisplayText[2][RPU_OS_NUM_DIGITS];
+// Alpha displays, rendered for the alpha PIA: port A in the high
+// byte and port B in the low byte
+volatile unsigned short DisplayGlyphs[2][RPU_OS_NUM_DIGITS];
 #endif
 
 #endif // End of condition based on RPU_MPU_ARCHITECTURE
@@ -108,16 +126,95 @@ volatile byte DisplayText[2][RPU_OS_NUM_DIGITS];
 // Global variables
 volatile byte DisplayDigits[5][RPU_OS_NUM_DIGITS];
 volatile byte DisplayDigitEnable[5];
+#if (RPU_MPU_ARCHITECTURE<10)
+// Display frame - for each digit, the U10A bytes that the display
+// interrupt writes to latch it (displays showing the same thing
+// share one strobe), and which of them also strobes display 4 (U11A:b0)
+volatile byte DisplayFramePulses[RPU_OS_NUM_DIGITS][5];
+volatile byte DisplayFrameNumPulses[RPU_OS_NUM_DIGITS];
+volatile byte DisplayFrameCreditPulse[RPU_OS_NUM_DIGITS];
+#endif
 volatile boolean DisplayOffCycle = false;
 volatile byte CurrentDisplayDigit=0;
 volatile byte LampStates[RPU_NUM_LAMP_BANKS], LampDim1[RPU_NUM_LAMP_BANKS], LampDim2[RPU_NUM_LAMP_BANKS];
 volatile byte LampFlashPeriod[RPU_MAX_LAMPS];
 byte DimDivisor1 = 2;
 byte DimDivisor2 = 3;
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+// Lamp brightness (RPU_SetLampBrightness) as bit-planes, a set bit
+// is a lamp that's off while that plane is showing. Plane n shows
+// on 2^n of every 15 lamp passes, spread out so the frame doesn't flicker.
+#define NUM_LAMP_BRIGHTNESS_PLANES  4
+#define NUM_LAMP_BRIGHTNESS_SLOTS   15
+volatile byte LampPlaneOff[NUM_LAMP_BRIGHTNESS_PLANES][RPU_NUM_LAMP_BANKS];
+const byte LampBrightnessSlotPlane[NUM_LAMP_BRIGHTNESS_SLOTS] = {3, 2, 3, 1, 3, 2, 3, 0, 3, 2, 3, 1, 3, 2, 3};
+byte LampBrightnessSlot = 0;
+#endif
+// Lamp passes into each dim cycle (they wrap at the divisors) - dim 1
+// lamps are off whenever LampDimPhase1 isn't zero, and the same for dim 2
+byte LampDimPhase1 = 0;
+byte LampDimPhase2 = 0;
+#if (RPU_MPU_ARCHITECTURE<10)
+#define NUM_LAMP_NIBBLES  (RPU_NUM_LAMP_BANKS*2)
+#ifdef RPU_OS_USE_LAMP_NIBBLE_TABLES
+// The U10A byte for every lamp nibble, ready for the zero-crossing
+// interrupt. There's a table for each dim phase:
+// [0] = no dimming, [1] = dim 1 off, [2] = dim 2 off, [3] = both off
+volatile byte LampNibbleOutput[4][NUM_LAMP_NIBBLES];
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+// The same for each brightness plane (upper nibble only, to be OR'd in)
+volatile byte LampPlaneNibbleOutput[NUM_LAMP_BRIGHTNESS_PLANES][NUM_LAMP_NIBBLES];
+#endif
+#endif
+#endif
 
-volatile byte SwitchesMinus2[NUM_SWITCH_BYTES];
 volatile byte SwitchesMinus1[NUM_SWITCH_BYTES];
 volatile byte SwitchesNow[NUM_SWITCH_BYTES];
+// Switches that push their (debounced) opens too (RPU_SetSwitchOpenEvents)
+byte SwitchOpenEvents[NUM_SWITCH_BYTES];
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+// High-rate switches (RPU_SetSwitchCoalescing) keep one closure on the
+// switch stack at a time, and count the closures it stands for
+byte SwitchCoalesce[NUM_SWITCH_BYTES];
+volatile byte SwitchCoalescedCount[MAX_NUM_SWITCHES];
+#endif
+
+// Debounced switch states (a set bit is a closed switch)
+byte SwitchesStable[NUM_SWITCH_BYTES];
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+// Debouncing (RPU_SetSwitchDebounce). Per-switch numbers are kept as
+// bit planes - bit n of plane k is bit k of switch n's number - so a
+// whole column is debounced with the same byte-wide operations,
+// however its switches are set up.
+#define SWITCH_SAMPLE_PLANES      3   /* samples to close/open, 1-7 */
+#define SWITCH_HOLD_OFF_PLANES    8   /* scans between closures, 0-255 */
+#define SWITCH_DEFAULT_CLOSE_SAMPLES  2   /* (off, on, on) */
+#define SWITCH_DEFAULT_OPEN_SAMPLES   1   /* (on, off) - one open sample ends a closure */
+#if (RPU_MPU_ARCHITECTURE<10)
+// Every column is read once per zero crossing (60 Hz mains)
+#define SWITCH_SCAN_MICROS        8333
+#else
+// Four columns per timer interrupt, so each one every other interrupt
+#define SWITCH_SCAN_MICROS        ((2UL*(INTERRUPT_OCR1A_COUNTER+1))/16)
+#endif
+byte SwitchChangeCount[SWITCH_SAMPLE_PLANES][NUM_SWITCH_BYTES];
+byte SwitchCloseSamples[SWITCH_SAMPLE_PLANES][NUM_SWITCH_BYTES];
+byte SwitchOpenSamples[SWITCH_SAMPLE_PLANES][NUM_SWITCH_BYTES];
+byte SwitchHoldOff[SWITCH_HOLD_OFF_PLANES][NUM_SWITCH_BYTES];
+byte SwitchRetrigger[SWITCH_HOLD_OFF_PLANES][NUM_SWITCH_BYTES];
+// Switches whose last closure was reported - an open only counts
+// if it ends one of those
+byte SwitchClosureReported[NUM_SWITCH_BYTES];
+#endif
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_SWITCH_SOLENOID_TABLE)
+// The game switch table by switch number (built by RPU_SetupGameSwitches)
+// b7 = priority switch, b6 = switch is in the table, b0-b5 = solenoid
+#define SWITCH_SOLENOID_PRIORITY      0x80
+#define SWITCH_SOLENOID_IN_TABLE      0x40
+#define SWITCH_SOLENOID_MASK          0x3F
+byte SwitchSolenoid[MAX_NUM_SWITCHES];
+byte SwitchSolenoidHoldTime[MAX_NUM_SWITCHES];
+#endif
 #ifdef RPU_OS_USE_DIP_SWITCHES
 byte DipSwitches[4];
 #endif
@@ -135,6 +232,18 @@ boolean SolenoidStackEnabled = true;
 volatile byte CurrentSolenoidByte = 0xFF;
 volatile byte RevertSolenoidBit = 0x00;
 volatile byte NumCyclesBeforeRevertingSolenoidByte = 0;
+#if (RPU_MPU_ARCHITECTURE>=10)
+// Coils that fire together each solenoid pass (and the passes they have
+// left), limited by the power budget and the coil groups
+#define MAX_FIRING_SOLENOIDS      6
+#define SOLENOID_PULLS_PER_PASS   8
+byte SolenoidPower[RPU_NUM_SOLENOIDS];
+byte SolenoidGroups[RPU_NUM_SOLENOIDS];
+byte SolenoidPowerBudget = 1;
+byte NumFiringSolenoids = 0;
+byte FiringSolenoid[MAX_FIRING_SOLENOIDS];
+byte FiringSolenoidPasses[MAX_FIRING_SOLENOIDS];
+#endif
 
 #define TIMED_SOLENOID_STACK_SIZE 30
 struct TimedSolenoidEntry {
@@ -148,9 +257,15 @@ TimedSolenoidEntry TimedSolenoidStack[TIMED_SOLENOID_STACK_SIZE] = {0, 0, 0, 0,
 
 #define SWITCH_STACK_SIZE   60
 #define SWITCH_STACK_EMPTY  0xFF
+// Set on the switch number for an open
+#define SWITCH_STACK_OPENED 0x80
 volatile byte SwitchStackFirst;
 volatile byte SwitchStackLast;
 volatile byte SwitchStack[SWITCH_STACK_SIZE];
+#ifdef RPU_OS_USE_SWITCH_EVENT_TIMES
+// micros() when each entry was pushed
+volatile unsigned long SwitchStackMicros[SWITCH_STACK_SIZE];
+#endif
 
 
 // The WTYPE1 and WTYPE2 sound cards can only play one sound at a time,
@@ -161,11 +276,17 @@ volatile byte SwitchStack[SWITCH_STACK_SIZE];
 // MPU Architecture > 9
 #if (RPU_MPU_ARCHITECTURE >= 10) 
 
-#define SOUND_STACK_SIZE  64
+// Each entry is a sound and how many more solenoid passes it's held
+// for (the interrupt counts them down in place)
+#define SOUND_STACK_SIZE  32
 #define SOUND_STACK_EMPTY 0x0000
+struct SoundStackEntry {
+  unsigned short soundNumber;
+  byte passes;
+};
 volatile byte SoundStackFirst;
 volatile byte SoundStackLast;
-volatile unsigned short SoundStack[SOUND_STACK_SIZE];
+volatile SoundStackEntry SoundStack[SOUND_STACK_SIZE];
 
 #define TIMED_SOUND_STACK_SIZE  20
 struct TimedSoundEntry {
@@ -281,6 +402,329 @@ TimedSoundEntry TimedSoundStack[TIMED_SOUND_STACK_SIZE] = {0, 0, 0, 0};
 #endif 
 
 
+/******************************************************
+ *   PIA Register Shadows
+ *
+ *   Every write to a PIA data or control register is
+ *   copied here, so code that only wants to change a
+ *   bit or two (CA2/CB2 lines, latch strobes) can do it
+ *   with a single bus write instead of a read and a write.
+ *   For each PIA: [0] = output A, [1] = control A,
+ *   [2] = output B, [3] = control B. Control shadows only
+ *   hold the writable bits (IRQ flags have to come from
+ *   a real read).
+ */
+#if (RPU_MPU_ARCHITECTURE<10)
+#define NUM_SHADOWED_PIAS   2
+
+inline byte PIAShadowIndex(int address) {
+  if ((address & 0xFFFC)==ADDRESS_U10_A) return (address & 0x03);
+  if ((address & 0xFFFC)==ADDRESS_U11_A) return 4 + (address & 0x03);
+  return 0xFF;
+}
+#else
+#define NUM_SHADOWED_PIAS   7
+
+inline byte PIAShadowIndex(int address) {
+  if (address & 0x00FC) return 0xFF;
+  switch (address & 0xFF00) {
+    case 0x2100: return 0 + (address & 0x03);
+    case 0x2200: return 4 + (address & 0x03);
+    case 0x2400: return 8 + (address & 0x03);
+    case 0x2800: return 12 + (address & 0x03);
+    case 0x2C00: return 16 + (address & 0x03);
+    case 0x3000: return 20 + (address & 0x03);
+    case 0x3400: return 24 + (address & 0x03);
+  }
+  return 0xFF;
+}
+#endif
+
+volatile byte PIARegisterShadow[NUM_SHADOWED_PIAS*4];
+
+inline void UpdatePIAShadow(int address, byte data) {
+  byte shadowIndex = PIAShadowIndex(address);
+  if (shadowIndex==0xFF) return;
+
+  if (shadowIndex & 0x01) {
+    // Control register
+    PIARegisterShadow[shadowIndex] = data & 0x3F;
+  } else if (PIARegisterShadow[shadowIndex+1] & 0x04) {
+    // Output register (if bit 2 of control is clear, this write went to the DDR)
+    PIARegisterShadow[shadowIndex] = data;
+  }
+}
+
+
+/******************************************************
+ *   Bus Trace
+ *
+ *   With RPU_OS_USE_BUS_TRACE defined, every bus cycle
+ *   (address, data, read/write, section) goes into a ring
+ *   buffer, along with a time-stamped marker at the start
+ *   of each interrupt pass. RPU_DumpBusTrace sends the
+ *   buffer over Serial as one binary frame:
+ *
+ *   'R' 'P' 'U' 'T', version, architecture,
+ *   entry count (2 bytes), cycles recorded since the
+ *   last dump (4 bytes), entries (4 bytes each: address
+ *   low, address high, data, flags), checksum (2 bytes,
+ *   sum of every byte after 'RPUT').
+ *   Multi-byte values are little endian.
+ *
+ *   Flags: bit 7 = read, bit 6 = pass marker,
+ *   bits 0-2 = RPU_BUS_SECTION_*. For a pass marker the
+ *   address is micros() & 0xFFFF and the data is the
+ *   handler (BUS_TRACE_*_PASS), with bit 7 set at the
+ *   end of the pass.
+ *
+ *   BusTraceAnalyzer (in this repo) decodes the dumps.
+ */
+#ifdef RPU_OS_USE_BUS_TRACE
+#ifndef RPU_BUS_TRACE_SIZE
+#define RPU_BUS_TRACE_SIZE  256
+#endif
+#if (RPU_BUS_TRACE_SIZE & (RPU_BUS_TRACE_SIZE-1))
+#error "RPU_BUS_TRACE_SIZE has to be a power of 2"
+#endif
+
+#define BUS_TRACE_VERSION       1
+#define BUS_TRACE_READ          0x80
+#define BUS_TRACE_PASS_MARKER   0x40
+#define BUS_TRACE_TIMER_PASS    0
+#define BUS_TRACE_IRQ_PASS      1
+#define BUS_TRACE_SWITCH_SCAN_PASS  2
+#define BUS_TRACE_PASS_END      0x80
+
+struct BusTraceEntry {
+  unsigned short address;
+  byte data;
+  byte flags;
+};
+
+BusTraceEntry BusTrace[RPU_BUS_TRACE_SIZE];
+volatile unsigned short BusTraceHead = 0;
+volatile unsigned long BusTraceRecorded = 0;
+volatile boolean BusTraceRunning = true;
+
+void RecordBusTrace(unsigned short address, byte data, byte flags) {
+  if (!BusTraceRunning) return;
+
+  // Main-loop bus cycles can be interrupted by the ISRs,
+  // which record too
+  byte oldSREG = SREG;
+  cli();
+  BusTraceEntry *entry = &BusTrace[BusTraceHead];
+  entry->address = address;
+  entry->data = data;
+  entry->flags = flags | (CurrentBusSection & 0x07);
+  BusTraceHead = (BusTraceHead + 1) & (RPU_BUS_TRACE_SIZE-1);
+  BusTraceRecorded += 1;
+  SREG = oldSREG;
+}
+
+#define RPU_TRACE_WRITE(address, data)  RecordBusTrace(address, data, 0)
+#define RPU_TRACE_READ(address, data)   RecordBusTrace(address, data, BUS_TRACE_READ)
+#define RPU_TRACE_PASS(pass)            RecordBusTrace((unsigned short)micros(), pass, BUS_TRACE_PASS_MARKER)
+#define RPU_TRACE_PASS_END(pass)        RecordBusTrace((unsigned short)micros(), (pass) | BUS_TRACE_PASS_END, BUS_TRACE_PASS_MARKER)
+
+void RPU_DumpBusTrace() {
+  // Recording stops while the frame goes out (the ISRs keep running)
+  BusTraceRunning = false;
+
+  unsigned long recorded = BusTraceRecorded;
+  unsigned short count = (recorded<RPU_BUS_TRACE_SIZE) ? recorded : RPU_BUS_TRACE_SIZE;
+  unsigned short entryNum = (BusTraceHead - count) & (RPU_BUS_TRACE_SIZE-1);
+
+  byte header[12] = { 'R', 'P', 'U', 'T', BUS_TRACE_VERSION, RPU_MPU_ARCHITECTURE,
+                      (byte)(count & 0xFF), (byte)(count >> 8),
+                      (byte)(recorded & 0xFF), (byte)(recorded >> 8), (byte)(recorded >> 16), (byte)(recorded >> 24) };
+  unsigned short checksum = 0;
+  for (byte byteNum=4; byteNum<12; byteNum++) checksum += header[byteNum];
+  Serial.write(header, 12);
+
+  for (; count; count--) {
+    byte entryBytes[4];
+    entryBytes[0] = BusTrace[entryNum].address & 0xFF;
+    entryBytes[1] = BusTrace[entryNum].address >> 8;
+    entryBytes[2] = BusTrace[entryNum].data;
+    entryBytes[3] = BusTrace[entryNum].flags;
+    checksum += entryBytes[0] + entryBytes[1] + entryBytes[2] + entryBytes[3];
+    Serial.write(entryBytes, 4);
+    entryNum = (entryNum + 1) & (RPU_BUS_TRACE_SIZE-1);
+  }
+
+  byte trailer[2] = { (byte)(checksum & 0xFF), (byte)(checksum >> 8) };
+  Serial.write(trailer, 2);
+
+  BusTraceHead = 0;
+  BusTraceRecorded = 0;
+  BusTraceRunning = true;
+}
+
+#else
+#define RPU_TRACE_WRITE(address, data)
+#define RPU_TRACE_READ(address, data)
+#define RPU_TRACE_PASS(pass)
+#define RPU_TRACE_PASS_END(pass)
+#endif
+
+
+/******************************************************
+ *   Interrupt Stats
+ *
+ *   With RPU_OS_USE_ISR_STATS defined, each ISR is timed
+ *   from a timer count read on the way in and out (RPU_ISR_*
+ *   in RPU.h), and timer 1's count on entry says how late
+ *   the handler started. Also counted: Arch 1 zero
+ *   crossings that came in while the last one was still
+ *   being handled, and the longest stretch the sound
+ *   functions held interrupts off.
+ *   RPU_GetISRStats returns a copy.
+ */
+#if (RPU_MPU_ARCHITECTURE<10)
+unsigned short DisplayRefreshConstant = RPU_OS_SOFTWARE_DISPLAY_INTERRUPT_INTERVAL;
+#endif
+#ifdef RPU_OS_ADAPTIVE_DISPLAY_REFRESH
+unsigned short DisplayRefreshChanges = 0;
+unsigned short AdaptiveRefreshLoopsPerSecond = 0;
+#endif
+
+void GetDisplayRefreshStats(RPUISRStats *stats) {
+#if (RPU_MPU_ARCHITECTURE>=10) && !defined(RPU_OS_ADAPTIVE_DISPLAY_REFRESH)
+  // (nothing to report on these boards)
+  (void)stats;
+#endif
+#if (RPU_MPU_ARCHITECTURE<10)
+  stats->displayRefreshConstant = DisplayRefreshConstant;
+#endif
+#ifdef RPU_OS_ADAPTIVE_DISPLAY_REFRESH
+  stats->displayRefreshChanges = DisplayRefreshChanges;
+  stats->loopsPerSecond = AdaptiveRefreshLoopsPerSecond;
+#endif
+}
+
+#ifdef RPU_OS_USE_ISR_STATS
+volatile unsigned long ISRCalls[RPU_NUM_ISRS];
+volatile unsigned short ISRAverageMicrosX8[RPU_NUM_ISRS];   // 8x the moving average
+volatile unsigned short ISRMaxMicros[RPU_NUM_ISRS];
+volatile unsigned short ISRMaxTimerSlotMicros[RPU_MAX_TIMER_SLOTS];
+volatile unsigned short ISRMaxTimerLateMicros = 0;
+volatile unsigned short ISRMaxMaskedMicros = 0;
+volatile unsigned long ISRSkippedZeroCrossings = 0;
+volatile unsigned long ISRBusyMicros[RPU_NUM_ISRS];   // total, for duty
+unsigned long InterruptsMaskedAt;
+
+unsigned short RecordISRTime(byte isr, unsigned short duration) {
+  if (duration>ISRMaxMicros[isr]) ISRMaxMicros[isr] = duration;
+  ISRCalls[isr] += 1;
+  ISRBusyMicros[isr] += duration;
+  unsigned short averaged = (duration>8191) ? 8191 : duration;
+  // (capped to keep the 16-bit sum from overflowing)
+  ISRAverageMicrosX8[isr] = ISRAverageMicrosX8[isr] - (ISRAverageMicrosX8[isr]/8) + averaged;
+  return duration;
+}
+
+void RecordTimerSlotTime(byte slot, unsigned short duration) {
+  if (slot<RPU_MAX_TIMER_SLOTS && duration>ISRMaxTimerSlotMicros[slot]) ISRMaxTimerSlotMicros[slot] = duration;
+}
+
+void RecordTimerLate(unsigned long lateMicros) {
+  if (lateMicros>0xFFFF) lateMicros = 0xFFFF;
+  if (lateMicros>ISRMaxTimerLateMicros) ISRMaxTimerLateMicros = lateMicros;
+}
+
+// For main-loop code that has to keep the interrupts out
+void MaskInterrupts() {
+  noInterrupts();
+  InterruptsMaskedAt = micros();
+}
+
+void UnmaskInterrupts() {
+  unsigned long masked = micros() - InterruptsMaskedAt;
+  if (masked>0xFFFF) masked = 0xFFFF;
+  if (masked>ISRMaxMaskedMicros) ISRMaxMaskedMicros = masked;
+  interrupts();
+}
+
+#if (RPU_MPU_ARCHITECTURE<10)
+// Timer 1 only counts 64 us here and starts over at every display
+// interrupt, so the handlers are timed on timer 0 (the millis timer),
+// which runs free at 4 us a count. A byte of it covers 1 ms, and
+// none of the Arch 1 handlers come close to that.
+#define RPU_ISR_STATS_BEGIN()           byte isrStartCount = TCNT0
+#define RPU_ISR_STATS_END(isr)          RecordISRTime(isr, ((byte)(TCNT0-isrStartCount))*4)
+#else
+// Timer 1 counts 1/16 us and goes back to 0 at OCR1A
+unsigned short TimerMicrosSince(unsigned short startCount) {
+  unsigned short count = TCNT1;
+  if (count<startCount) count += OCR1A+1;
+  return (count-startCount)/16;
+}
+
+#define RPU_ISR_STATS_BEGIN()           unsigned short isrStartCount = TCNT1
+#define RPU_ISR_STATS_END_SLOT(isr, slot) RecordTimerSlotTime(slot, RecordISRTime(isr, TimerMicrosSince(isrStartCount)))
+#endif
+#define RPU_ISR_STATS_TIMER_LATE(late)  RecordTimerLate(late)
+#define RPU_ISR_STATS_SKIPPED_CROSSING() ISRSkippedZeroCrossings += 1
+
+void RPU_GetISRStats(RPUISRStats *stats) {
+  byte oldSREG = SREG;
+  cli();
+  for (byte isr=0; isr<RPU_NUM_ISRS; isr++) {
+    stats->calls[isr] = ISRCalls[isr];
+    stats->averageMicros[isr] = ISRAverageMicrosX8[isr]/8;
+    stats->maxMicros[isr] = ISRMaxMicros[isr];
+  }
+  for (byte slot=0; slot<RPU_MAX_TIMER_SLOTS; slot++) stats->maxTimerSlotMicros[slot] = ISRMaxTimerSlotMicros[slot];
+  stats->maxTimerLateMicros = ISRMaxTimerLateMicros;
+  stats->maxMaskedMicros = ISRMaxMaskedMicros;
+  stats->skippedZeroCrossings = ISRSkippedZeroCrossings;
+  SREG = oldSREG;
+  GetDisplayRefreshStats(stats);
+}
+
+void RPU_ResetISRStats() {
+  byte oldSREG = SREG;
+  cli();
+  for (byte isr=0; isr<RPU_NUM_ISRS; isr++) {
+    ISRCalls[isr] = 0;
+    ISRAverageMicrosX8[isr] = 0;
+    ISRMaxMicros[isr] = 0;
+    ISRBusyMicros[isr] = 0;
+  }
+  for (byte slot=0; slot<RPU_MAX_TIMER_SLOTS; slot++) ISRMaxTimerSlotMicros[slot] = 0;
+  ISRMaxTimerLateMicros = 0;
+  ISRMaxMaskedMicros = 0;
+  ISRSkippedZeroCrossings = 0;
+  SREG = oldSREG;
+}
+
+#else
+#define RPU_ISR_STATS_BEGIN()
+#define RPU_ISR_STATS_END(isr)
+#define RPU_ISR_STATS_END_SLOT(isr, slot)
+#define RPU_ISR_STATS_TIMER_LATE(late)
+#define RPU_ISR_STATS_SKIPPED_CROSSING()
+
+inline void MaskInterrupts() {
+  noInterrupts();
+}
+
+inline void UnmaskInterrupts() {
+  interrupts();
+}
+
+void RPU_GetISRStats(RPUISRStats *stats) {
+  memset(stats, 0, sizeof(RPUISRStats));
+  GetDisplayRefreshStats(stats);
+}
+
+void RPU_ResetISRStats() {
+}
+#endif
+
+
 /******************************************************
  *   Hardware Interface Functions
  *   
@@ -309,7 +753,9 @@ TimedSoundEntry TimedSoundStack[TIMED_SOUND_STACK_SIZE] = {0, 0, 0, 0};
 #error "ATMega requires RPU_OS_HARDWARE_REV of 3, check RPU_Config.h and adjust settings"
 #endif
 
-void RPU_DataWrite(int address, byte data) {
+template <boolean M6800> void DataWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
   
   // Set data pins to output
   // Make pins 5-7 output (and pin 3 for R/W)
@@ -363,7 +809,7 @@ void RPU_DataWrite(int address, byte data) {
 
 
 
-byte RPU_DataRead(int address) {
+template <boolean M6800> byte DataRead(int address) {
   
   // Set data pins to input
   // Make pins 5-7 input
@@ -410,6 +856,7 @@ byte RPU_DataRead(int address) {
   // Clear address lines
   PORTC = (PORTC & 0xE0);
 
+  RPU_TRACE_READ(address, inputData);
   return inputData;
 }
 
@@ -424,6 +871,19 @@ void WaitClockCycle(int numCycles=1) {
   }
 }
 
+
+// Rev 1/2 boards don't have burst writes,
+// so these fall back to regular writes
+void RPU_BusBegin() {
+}
+
+template <boolean M6800> void BusWrite(int address, byte data) {
+  DataWrite<M6800>(address, data);
+}
+
+void RPU_BusEnd() {
+}
+
 #elif (RPU_OS_HARDWARE_REV==3)
 
 // Rev 3 connections
@@ -442,7 +902,9 @@ void WaitClockCycle(int numCycles=1) {
 #endif
 
 
-void RPU_DataWrite(int address, byte data) {
+template <boolean M6800> void DataWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
   
   // Set data pins to output
   DDRH = DDRH | 0x78;
@@ -502,8 +964,78 @@ void RPU_DataWrite(int address, byte data) {
 }
 
 
+// Burst writes leave the data pins as outputs and R/W low
+// between writes, so each RPU_BusWrite only has to put
+// the address & data on the bus and pulse VMA
+void RPU_BusBegin() {
+  // Set data pins to output
+  DDRH = DDRH | 0x78;
+  DDRB = DDRB | 0x70;
+  DDRJ = DDRJ | 0x01;
 
-byte RPU_DataRead(int address) {
+  // Set R/W to LOW
+  PORTE = (PORTE & 0xF7);
+}
+
+
+template <boolean M6800> void BusWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
+
+  // Put data on pins
+  // Lower Nibble goes on PortH3 through H6
+  PORTH = (PORTH&0x87) | ((data&0x0F)<<3);
+  // Bits 4-6 go on PortB4 through B6
+  PORTB = (PORTB&0x8F) | ((data&0x70));
+  // Bit 7 goes on PortJ0
+  PORTJ = (PORTJ&0xFE) | (data>>7);  
+
+  // Set up address lines
+  PORTH = (PORTH & 0xFC) | ((address & 0x0001)<<1) | ((address & 0x0002)>>1); // A0-A1
+  PORTD = (PORTD & 0xF0) | ((address & 0x0004)<<1) | ((address & 0x0008)>>1) | ((address & 0x0010)>>3) | ((address & 0x0020)>>5); // A2-A5
+  PORTA = ((address & 0x3FC0)>>6); // A6-A13
+  PORTC = (PORTC & 0x3F) | ((address & 0x4000)>>7) | ((address & 0x8000)>>9); // A14-A15
+
+  // Wait for a falling edge of the clock
+  while((PINE & 0x20));
+
+  // Pulse VMA over one clock cycle
+  // Set VMA ON
+  PORTG = PORTG | 0x20;
+
+  // Wait while clock is low
+  while(!(PINE & 0x20));
+
+  // Wait while clock is high
+  while((PINE & 0x20));
+
+  // Wait while clock is low
+  while(!(PINE & 0x20));
+
+  // Set VMA OFF
+  PORTG = PORTG & 0xDF;
+}
+
+
+void RPU_BusEnd() {
+  // Unset address lines
+  PORTH = (PORTH & 0xFC);
+  PORTD = (PORTD & 0xF0);
+  PORTA = 0;
+  PORTC = (PORTC & 0x3F);
+  
+  // Set R/W back to HIGH
+  PORTE = (PORTE | 0x08);
+
+  // Set data pins to input
+  DDRH = DDRH & 0x87;
+  DDRB = DDRB & 0x8F;
+  DDRJ = DDRJ & 0xFE;
+}
+
+
+
+template <boolean M6800> byte DataRead(int address) {
   
   // Set data pins to input
   DDRH = DDRH & 0x87;
@@ -555,6 +1087,7 @@ byte RPU_DataRead(int address) {
   PORTA = 0;
   PORTC = (PORTC & 0x3F);
 
+  RPU_TRACE_READ(address, inputData);
   return inputData;
 }
 
@@ -611,7 +1144,9 @@ void RPU_SetDataPinsDirection(boolean pinsOutput) {
 
 
 // REVISION 4 HARDWARE
-void RPU_DataWrite(int address, byte data) {
+template <boolean M6800> void DataWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
   
   // Set data pins to output
   DDRA = 0xFF;
@@ -626,7 +1161,7 @@ void RPU_DataWrite(int address, byte data) {
   PORTF = (byte)(address & 0x00FF);
   PORTK = (byte)(address/256);
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait for a falling edge of the clock
     while((PING & 0x04));
   } else {
@@ -638,7 +1173,7 @@ void RPU_DataWrite(int address, byte data) {
   // Set VMA ON
   PORTG = PORTG | 0x02;
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait while clock is low
     while(!(PING & 0x04));
   
@@ -674,7 +1209,80 @@ void RPU_DataWrite(int address, byte data) {
 }
 
 
-byte RPU_DataRead(int address) {
+// Burst writes leave the data pins as outputs and R/W low
+// between writes, so each RPU_BusWrite only has to put
+// the address & data on the bus and pulse VMA
+void RPU_BusBegin() {
+  // Set data pins to output
+  DDRA = 0xFF;
+
+  // Set R/W to LOW
+  PORTE = (PORTE & 0xDF);
+}
+
+
+template <boolean M6800> void BusWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
+
+  // Put data on pins
+  PORTA = data;
+
+  // Set up address lines
+  PORTF = (byte)(address & 0x00FF);
+  PORTK = (byte)(address/256);
+
+  if (M6800) {
+    // Wait for a falling edge of the clock
+    while((PING & 0x04));
+  } else {
+    // Set clock low (PG2) (if 6802/8)
+    PORTG &= ~0x04;
+  }
+  
+  // Pulse VMA over one clock cycle
+  // Set VMA ON
+  PORTG = PORTG | 0x02;
+
+  if (M6800) {
+    // Wait while clock is low
+    while(!(PING & 0x04));
+  
+    // Wait while clock is high
+    while((PING & 0x04));
+  
+    // Wait while clock is low
+    while(!(PING & 0x04));  
+  } else {
+    // Set clock high
+    PORTG |= 0x04;
+  
+    // Set clock low
+    PORTG &= ~0x04;
+  
+    // Set clock high
+    PORTG |= 0x04;
+  }
+
+  // Set VMA OFF
+  PORTG = PORTG & 0xFD;
+}
+
+
+void RPU_BusEnd() {
+  // Unset address lines
+  PORTF = 0x00;
+  PORTK = 0x00;
+  
+  // Set R/W back to HIGH
+  PORTE = (PORTE | 0x20);
+
+  // Set data pins to input
+  DDRA = 0x00;
+}
+
+
+template <boolean M6800> byte DataRead(int address) {
   
   // Set data pins to input
   DDRA = 0x00;
@@ -687,7 +1295,7 @@ byte RPU_DataRead(int address) {
   PORTF = (byte)(address & 0x00FF);
   PORTK = (byte)(address/256);
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait for a falling edge of the clock
     while((PING & 0x04));
   } else {
@@ -699,7 +1307,7 @@ byte RPU_DataRead(int address) {
   // Set VMA ON
   PORTG = PORTG | 0x02;
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait a full clock cycle to make sure data lines are ready
     // (important for faster clocks)
     // Wait while clock is low
@@ -734,6 +1342,7 @@ byte RPU_DataRead(int address) {
   PORTF = 0x00;
   PORTK = 0x00;
 
+  RPU_TRACE_READ(address, inputData);
   return inputData;
 }
 
@@ -768,7 +1377,9 @@ void RPU_SetDataPinsDirection(boolean pinsOutput) {
 
 
 // REV 100 HARDWARE
-void RPU_DataWrite(int address, byte data) {
+template <boolean M6800> void DataWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
   
   // Set data pins to output
   DDRH = DDRH | 0x78;
@@ -828,8 +1439,78 @@ void RPU_DataWrite(int address, byte data) {
 }
 
 
+// Burst writes leave the data pins as outputs and R/W low
+// between writes, so each RPU_BusWrite only has to put
+// the address & data on the bus and pulse VMA
+void RPU_BusBegin() {
+  // Set data pins to output
+  DDRH = DDRH | 0x78;
+  DDRB = DDRB | 0x70;
+  DDRJ = DDRJ | 0x01;
 
-byte RPU_DataRead(int address) {
+  // Set R/W to LOW
+  PORTE = (PORTE & 0xF7);
+}
+
+
+template <boolean M6800> void BusWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
+
+  // Put data on pins
+  // Lower Nibble goes on PortH3 through H6
+  PORTH = (PORTH&0x87) | ((data&0x0F)<<3);
+  // Bits 4-6 go on PortB4 through B6
+  PORTB = (PORTB&0x8F) | ((data&0x70));
+  // Bit 7 goes on PortJ0
+  PORTJ = (PORTJ&0xFE) | (data>>7);  
+
+  // Set up address lines
+  PORTH = (PORTH & 0xFC) | ((address & 0x0001)<<1) | ((address & 0x0002)>>1); // A0-A1
+  PORTD = (PORTD & 0xF0) | ((address & 0x0004)<<1) | ((address & 0x0008)>>1) | ((address & 0x0010)>>3) | ((address & 0x0020)>>5); // A2-A5
+  PORTA = ((address & 0x3FC0)>>6); // A6-A13
+  PORTC = (PORTC & 0x3F) | ((address & 0x4000)>>7) | ((address & 0x8000)>>9); // A14-A15
+
+  // Set clock low
+  PORTE &= ~0x20;
+
+  // Pulse VMA over one clock cycle
+  // Set VMA ON
+  PORTG = PORTG | 0x20;
+
+  // Set clock high
+  PORTE |= 0x20;
+
+  // Set clock low
+  PORTE &= ~0x20;
+
+  // Set clock high
+  PORTE |= 0x20;
+
+  // Set VMA OFF
+  PORTG = PORTG & 0xDF;
+}
+
+
+void RPU_BusEnd() {
+  // Unset address lines
+  PORTH = (PORTH & 0xFC);
+  PORTD = (PORTD & 0xF0);
+  PORTA = 0;
+  PORTC = (PORTC & 0x3F);
+  
+  // Set R/W back to HIGH
+  PORTE = (PORTE | 0x08);
+
+  // Set data pins to input
+  DDRH = DDRH & 0x87;
+  DDRB = DDRB & 0x8F;
+  DDRJ = DDRJ & 0xFE;
+}
+
+
+
+template <boolean M6800> byte DataRead(int address) {
   
   // Set data pins to input
   DDRH = DDRH & 0x87;
@@ -879,6 +1560,7 @@ byte RPU_DataRead(int address) {
   PORTA = 0;
   PORTC = (PORTC & 0x3F);
 
+  RPU_TRACE_READ(address, inputData);
   return inputData;
 }
 
@@ -932,7 +1614,9 @@ void RPU_SetDataPinsDirection(boolean pinsOutput) {
 
 
 // REVISION 101/102 HARDWARE
-void RPU_DataWrite(int address, byte data) {
+template <boolean M6800> void DataWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
   
   // Set data pins to output
   DDRA = 0xFF;
@@ -947,7 +1631,7 @@ void RPU_DataWrite(int address, byte data) {
   PORTF = (byte)(address & 0x00FF);
   PORTK = (byte)(address/256);
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait for a falling edge of the clock
     while((PING & 0x04));
   } else {
@@ -959,7 +1643,7 @@ void RPU_DataWrite(int address, byte data) {
   // Set VMA ON
   PORTG = PORTG | 0x02;
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait while clock is low
     while(!(PING & 0x04));
   
@@ -995,8 +1679,81 @@ void RPU_DataWrite(int address, byte data) {
 }
 
 
+// Burst writes leave the data pins as outputs and R/W low
+// between writes, so each RPU_BusWrite only has to put
+// the address & data on the bus and pulse VMA
+void RPU_BusBegin() {
+  // Set data pins to output
+  DDRA = 0xFF;
 
-byte RPU_DataRead(int address) {
+  // Set R/W to LOW
+  PORTE = (PORTE & 0xDF);
+}
+
+
+template <boolean M6800> void BusWrite(int address, byte data) {
+  UpdatePIAShadow(address, data);
+  RPU_TRACE_WRITE(address, data);
+
+  // Put data on pins
+  PORTA = data;
+
+  // Set up address lines
+  PORTF = (byte)(address & 0x00FF);
+  PORTK = (byte)(address/256);
+
+  if (M6800) {
+    // Wait for a falling edge of the clock
+    while((PING & 0x04));
+  } else {
+    // Set clock low (PG2) (if 6802/8)
+    PORTG &= ~0x04;
+  }
+  
+  // Pulse VMA over one clock cycle
+  // Set VMA ON
+  PORTG = PORTG | 0x02;
+
+  if (M6800) {
+    // Wait while clock is low
+    while(!(PING & 0x04));
+  
+    // Wait while clock is high
+    while((PING & 0x04));
+  
+    // Wait while clock is low
+    while(!(PING & 0x04));  
+  } else {
+    // Set clock high
+    PORTG |= 0x04;
+  
+    // Set clock low
+    PORTG &= ~0x04;
+  
+    // Set clock high
+    PORTG |= 0x04;
+  }
+
+  // Set VMA OFF
+  PORTG = PORTG & 0xFD;
+}
+
+
+void RPU_BusEnd() {
+  // Unset address lines
+  PORTF = 0x00;
+  PORTK = 0x00;
+  
+  // Set R/W back to HIGH
+  PORTE = (PORTE | 0x20);
+
+  // Set data pins to input
+  DDRA = 0x00;
+}
+
+
+
+template <boolean M6800> byte DataRead(int address) {
   
   // Set data pins to input
   DDRA = 0x00;
@@ -1009,7 +1766,7 @@ byte RPU_DataRead(int address) {
   PORTF = (byte)(address & 0x00FF);
   PORTK = (byte)(address/256);
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait for a falling edge of the clock
     while((PING & 0x04));
   } else {
@@ -1021,7 +1778,7 @@ byte RPU_DataRead(int address) {
   // Set VMA ON
   PORTG = PORTG | 0x02;
 
-  if (UsesM6800Processor) {
+  if (M6800) {
     // Wait a full clock cycle to make sure data lines are ready
     // (important for faster clocks)
     // Wait while clock is low
@@ -1056,6 +1813,7 @@ byte RPU_DataRead(int address) {
   PORTF = 0x00;
   PORTK = 0x00;
 
+  RPU_TRACE_READ(address, inputData);
   return inputData;
 }
 
@@ -1065,14 +1823,68 @@ byte RPU_DataRead(int address) {
 #endif
 
 
+// Each board's bus access is built for a given CPU clocking (the 6800
+// supplies PHI2, a 6802/8 needs us to drive it). The ISRs are built
+// against the right one, so only these general calls have to choose.
+#if (RPU_OS_HARDWARE_REV==102)
+void RPU_DataWrite(int address, byte data) {
+  if (UsesM6800Processor) DataWrite<true>(address, data);
+  else DataWrite<false>(address, data);
+}
+
+byte RPU_DataRead(int address) {
+  if (UsesM6800Processor) return DataRead<true>(address);
+  else return DataRead<false>(address);
+}
+
+void RPU_BusWrite(int address, byte data) {
+  if (UsesM6800Processor) BusWrite<true>(address, data);
+  else BusWrite<false>(address, data);
+}
+#else
+void RPU_DataWrite(int address, byte data) {
+  DataWrite<BUILT_FOR_M6800>(address, data);
+}
+
+byte RPU_DataRead(int address) {
+  return DataRead<BUILT_FOR_M6800>(address);
+}
+
+void RPU_BusWrite(int address, byte data) {
+  BusWrite<BUILT_FOR_M6800>(address, data);
+}
+#endif
+
+
+// Returns the last value written to a PIA output or control register
+// (without touching the bus, so IRQ flags aren't cleared)
+byte RPU_ReadRegisterShadow(int address) {
+  byte shadowIndex = PIAShadowIndex(address);
+  if (shadowIndex==0xFF) return 0x00;
+  return PIARegisterShadow[shadowIndex];
+}
+
+void RPU_SetRegisterBits(int address, byte bits) {
+  byte shadowIndex = PIAShadowIndex(address);
+  if (shadowIndex==0xFF) return;
+  RPU_DataWrite(address, PIARegisterShadow[shadowIndex] | bits);
+}
+
+void RPU_ClearRegisterBits(int address, byte bits) {
+  byte shadowIndex = PIAShadowIndex(address);
+  if (shadowIndex==0xFF) return;
+  RPU_DataWrite(address, PIARegisterShadow[shadowIndex] & ~bits);
+}
+
+
 #if (RPU_MPU_ARCHITECTURE<10)
 
 void TestLightOn() {
-  RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL) | 0x08);
+  RPU_SetRegisterBits(ADDRESS_U11_A_CONTROL, 0x08);
 }
 
 void TestLightOff() {
-  RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL) & 0xF7);
+  RPU_ClearRegisterBits(ADDRESS_U11_A_CONTROL, 0x08);
 }
 
 
@@ -1089,7 +1901,7 @@ void InitializeU10PIA() {
   // Set up U10A as output
   RPU_DataWrite(ADDRESS_U10_A, 0xFF);
   // Set bit 3 to write data
-  RPU_DataWrite(ADDRESS_U10_A_CONTROL, RPU_DataRead(ADDRESS_U10_A_CONTROL)|0x04);
+  RPU_SetRegisterBits(ADDRESS_U10_A_CONTROL, 0x04);
   // Store F0 in U10A Output
   RPU_DataWrite(ADDRESS_U10_A, 0xF0);
   
@@ -1097,14 +1909,14 @@ void InitializeU10PIA() {
   // Set up U10B as input
   RPU_DataWrite(ADDRESS_U10_B, 0x00);
   // Set bit 3 so future reads will read data
-  RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL)|0x04);
+  RPU_SetRegisterBits(ADDRESS_U10_B_CONTROL, 0x04);
 
 }
 
 #ifdef RPU_OS_USE_DIP_SWITCHES
 void ReadDipSwitches() {
-  byte backupU10A = RPU_DataRead(ADDRESS_U10_A);
-  byte backupU10BControl = RPU_DataRead(ADDRESS_U10_B_CONTROL);
+  byte backupU10A = RPU_ReadRegisterShadow(ADDRESS_U10_A);
+  byte backupU10BControl = RPU_ReadRegisterShadow(ADDRESS_U10_B_CONTROL);
 
   // Turn on Switch strobe 5 & Read Switches
   RPU_DataWrite(ADDRESS_U10_A, 0x20);
@@ -1151,7 +1963,7 @@ void InitializeU11PIA() {
   // Set up U11A as output
   RPU_DataWrite(ADDRESS_U11_A, 0xFF);
   // Set bit 3 to write data
-  RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL)|0x04);
+  RPU_SetRegisterBits(ADDRESS_U11_A_CONTROL, 0x04);
   // Store 00 in U11A Output
   RPU_DataWrite(ADDRESS_U11_A, 0x00);
   
@@ -1159,7 +1971,7 @@ void InitializeU11PIA() {
   // Set up U11B as output
   RPU_DataWrite(ADDRESS_U11_B, 0xFF);
   // Set bit 3 so future reads will read data
-  RPU_DataWrite(ADDRESS_U11_B_CONTROL, RPU_DataRead(ADDRESS_U11_B_CONTROL)|0x04);
+  RPU_SetRegisterBits(ADDRESS_U11_B_CONTROL, 0x04);
   // Store 9F in U11B Output
   RPU_DataWrite(ADDRESS_U11_B, DEFAULT_SOLENOID_STATE);
   CurrentSolenoidByte = DEFAULT_SOLENOID_STATE;
@@ -1183,6 +1995,25 @@ unsigned long RPU_TestPIAs() {
   return piaErrors;
 }
 
+// For RPU_TestBus: the control registers to walk (and the error each
+// one reports), and the register the data lines are tested through.
+// Port A reads back pin levels (which a closed switch or a load can
+// pull), U10 A carries the display latch strobes, and U11 B fires
+// solenoids, so the lines are walked through the DDR of U10 B instead.
+// Those are the switch returns - all inputs, and pulled low while no
+// column is strobed - so turning them into outputs driving 0 for a
+// moment fights nothing.
+#define NUM_BUS_TEST_CONTROL_REGISTERS  4
+const int BusTestControlRegisters[NUM_BUS_TEST_CONTROL_REGISTERS] = {
+  ADDRESS_U10_A_CONTROL, ADDRESS_U10_B_CONTROL, ADDRESS_U11_A_CONTROL, ADDRESS_U11_B_CONTROL
+};
+const byte BusTestControlErrors[NUM_BUS_TEST_CONTROL_REGISTERS] = {
+  RPU_RET_U10_PIA_ERROR, RPU_RET_U10_PIA_ERROR, RPU_RET_U11_PIA_ERROR, RPU_RET_U11_PIA_ERROR
+};
+#define BUS_TEST_DATA_PORT    ADDRESS_U10_B
+#define BUS_TEST_DATA_CONTROL ADDRESS_U10_B_CONTROL
+#define BUS_TEST_WALKS_DDR
+
 #else
 
 void RPU_InitializePIAs() {
@@ -1314,6 +2145,39 @@ unsigned long RPU_TestPIAs() {
   return piaErrors;
 }
 
+// For RPU_TestBus (see above). PIA 5 stands for the sound/comma PIA on
+// Sys 7, and for the sound, alpha and widget PIAs on Sys 11.
+#if (RPU_MPU_ARCHITECTURE==15)
+#define NUM_BUS_TEST_CONTROL_REGISTERS  14
+#elif (RPU_MPU_ARCHITECTURE==13)
+#define NUM_BUS_TEST_CONTROL_REGISTERS  10
+#else
+#define NUM_BUS_TEST_CONTROL_REGISTERS  8
+#endif
+const int BusTestControlRegisters[NUM_BUS_TEST_CONTROL_REGISTERS] = {
+  PIA_DISPLAY_CONTROL_A, PIA_DISPLAY_CONTROL_B, PIA_SWITCH_CONTROL_A, PIA_SWITCH_CONTROL_B,
+  PIA_LAMPS_CONTROL_A, PIA_LAMPS_CONTROL_B, PIA_SOLENOID_CONTROL_A, PIA_SOLENOID_CONTROL_B,
+#if (RPU_MPU_ARCHITECTURE==13)
+  PIA_SOUND_COMMA_CONTROL_A, PIA_SOUND_COMMA_CONTROL_B
+#elif (RPU_MPU_ARCHITECTURE==15)
+  PIA_SOUND_11_CONTROL_A, PIA_SOLENOID_11_CONTROL_B, PIA_ALPHA_DISPLAY_CONTROL_A, PIA_ALPHA_DISPLAY_CONTROL_B,
+  PIA_NUM_DISPLAY_CONTROL_A, PIA_WIDGET_CONTROL_B
+#endif
+};
+const byte BusTestControlErrors[NUM_BUS_TEST_CONTROL_REGISTERS] = {
+  RPU_RET_PIA_1_ERROR, RPU_RET_PIA_1_ERROR, RPU_RET_PIA_2_ERROR, RPU_RET_PIA_2_ERROR,
+  RPU_RET_PIA_3_ERROR, RPU_RET_PIA_3_ERROR, RPU_RET_PIA_4_ERROR, RPU_RET_PIA_4_ERROR,
+#if (RPU_MPU_ARCHITECTURE==13)
+  RPU_RET_PIA_5_ERROR, RPU_RET_PIA_5_ERROR
+#elif (RPU_MPU_ARCHITECTURE==15)
+  RPU_RET_PIA_5_ERROR, RPU_RET_PIA_5_ERROR, RPU_RET_PIA_5_ERROR, RPU_RET_PIA_5_ERROR,
+  RPU_RET_PIA_5_ERROR, RPU_RET_PIA_5_ERROR
+#endif
+};
+// (port B reads back its output register, and it only strobes the
+// switch columns)
+#define BUS_TEST_DATA_PORT    PIA_SWITCH_PORT_B
+
 void RPU_SetBoardLEDs(boolean LED1, boolean LED2, byte BCDValue) {
   BoardLEDs = 0;
   if (BCDValue==0xFF) {
@@ -1327,6 +2191,116 @@ void RPU_SetBoardLEDs(boolean LED1, boolean LED2, byte BCDValue) {
 #endif
 
 
+/******************************************************
+ *   Extended PIA / Bus Test
+ *
+ *   Walks the IRQ enable and DDR select bits (0-2) of every
+ *   PIA control register (CA2/CB2 are left alone so nothing
+ *   on the playfield changes), walks patterns through one
+ *   register that reads back exactly what was written to
+ *   find stuck or shorted data lines, and times RPU_DataRead
+ *   & RPU_DataWrite on it. The data and DDR registers of the
+ *   other PIAs aren't walked - they drive lamps, solenoids
+ *   and displays, and port A reads back pin levels anyway.
+ */
+#define BUS_TEST_NUM_PATTERNS     20
+#define BUS_TEST_TIMING_ACCESSES  64
+
+RPUBusTestResults LastBusTestResults;
+
+byte BusTestPattern(byte patternNum) {
+  if (patternNum<8) return (0x01<<patternNum);
+  if (patternNum<16) return ~(0x01<<(patternNum-8));
+  switch (patternNum) {
+    case 16: return 0x00;
+    case 17: return 0xFF;
+    case 18: return 0x55;
+  }
+  return 0xAA;
+}
+
+unsigned long RPU_TestBus(RPUBusTestResults *results) {
+  RPUBusTestResults busTest;
+  busTest.piaErrors = RPU_TestPIAs();
+
+  // The interrupts touch these registers too, so they're
+  // held off for each part of the test
+  byte oldSREG = SREG;
+
+  for (byte count=0; count<NUM_BUS_TEST_CONTROL_REGISTERS; count++) {
+    int controlAddress = BusTestControlRegisters[count];
+    byte savedControl = RPU_ReadRegisterShadow(controlAddress);
+    cli();
+    for (byte pattern=0; pattern<0x08; pattern++) {
+      byte testValue = (savedControl & 0x38) | pattern;
+      RPU_DataWrite(controlAddress, testValue);
+      if ((RPU_DataRead(controlAddress)&0x3F)!=testValue) busTest.piaErrors |= BusTestControlErrors[count];
+    }
+    RPU_DataWrite(controlAddress, savedControl);
+    SREG = oldSREG;
+  }
+
+  byte sawHigh = 0;
+  byte sawLow = 0;
+  byte wrongLines = 0;
+#ifdef BUS_TEST_WALKS_DDR
+  // No switch column strobed (U10 A and CB2 low), the output register
+  // at 0, and then the DDR selected
+  byte savedData = 0x00;
+  byte savedStrobes = RPU_ReadRegisterShadow(ADDRESS_U10_A);
+  byte savedDataControl = RPU_ReadRegisterShadow(BUS_TEST_DATA_CONTROL);
+  cli();
+  RPU_DataWrite(ADDRESS_U10_A, 0x00);
+  RPU_DataWrite(BUS_TEST_DATA_CONTROL, (savedDataControl & 0xF3) | 0x34);
+  RPU_DataWrite(BUS_TEST_DATA_PORT, 0x00);
+  RPU_DataWrite(BUS_TEST_DATA_CONTROL, (savedDataControl & 0xF3) | 0x30);
+#else
+  byte savedData = RPU_ReadRegisterShadow(BUS_TEST_DATA_PORT);
+  cli();
+#endif
+  for (byte patternNum=0; patternNum<BUS_TEST_NUM_PATTERNS; patternNum++) {
+    byte pattern = BusTestPattern(patternNum);
+    RPU_DataWrite(BUS_TEST_DATA_PORT, pattern);
+    byte readBack = RPU_DataRead(BUS_TEST_DATA_PORT);
+    sawHigh |= readBack;
+    sawLow |= ~readBack;
+    wrongLines |= (readBack ^ pattern);
+  }
+
+  unsigned long startTime = micros();
+  for (byte count=0; count<BUS_TEST_TIMING_ACCESSES; count++) RPU_DataWrite(BUS_TEST_DATA_PORT, savedData);
+  busTest.writeNanoseconds = ((micros()-startTime)*1000)/BUS_TEST_TIMING_ACCESSES;
+  startTime = micros();
+  for (byte count=0; count<BUS_TEST_TIMING_ACCESSES; count++) RPU_DataRead(BUS_TEST_DATA_PORT);
+  busTest.readNanoseconds = ((micros()-startTime)*1000)/BUS_TEST_TIMING_ACCESSES;
+#ifdef BUS_TEST_WALKS_DDR
+  // (the DDR is back to all inputs from the timing writes)
+  RPU_DataWrite(BUS_TEST_DATA_CONTROL, savedDataControl);
+  RPU_DataWrite(ADDRESS_U10_A, savedStrobes);
+#endif
+  SREG = oldSREG;
+
+  busTest.stuckHighLines = ~sawLow;
+  busTest.stuckLowLines = ~sawHigh;
+  busTest.shortedLines = wrongLines & ~(busTest.stuckHighLines | busTest.stuckLowLines);
+  if (wrongLines) busTest.piaErrors |= RPU_RET_DATA_LINE_ERROR;
+
+  if (DEBUG_MESSAGES) {
+    char buf[128];
+    sprintf(buf, "* Bus test: errors=0x%05lX, read=%u ns, write=%u ns\n", busTest.piaErrors, busTest.readNanoseconds, busTest.writeNanoseconds);
+    Serial.write(buf);
+  }
+
+  LastBusTestResults = busTest;
+  if (results) *results = busTest;
+  return busTest.piaErrors;
+}
+
+void RPU_GetBusTestResults(RPUBusTestResults *results) {
+  *results = LastBusTestResults;
+}
+
+
 
 /******************************************************
  *   Switch Handling Functions
@@ -1342,39 +2316,226 @@ void PushToSwitchStack(byte switchNumber) {
   //if ((switchNumber>=MAX_NUM_SWITCHES && switchNumber!=SW_SELF_TEST_SWITCH)) return;
   if (switchNumber==SWITCH_STACK_EMPTY) return;
 
-  // If the switch stack last index is out of range, then it's an error - return
-  if (SpaceLeftOnSwitchStack()==0) return;
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  // If a high-rate switch already has a closure waiting, count this one on it
+  boolean coalesce = (switchNumber<MAX_NUM_SWITCHES && (SwitchCoalesce[switchNumber/8] & (1<<(switchNumber%8))));
+  if (coalesce && SwitchCoalescedCount[switchNumber]) {
+    if (SwitchCoalescedCount[switchNumber]<255) SwitchCoalescedCount[switchNumber] += 1;
+    return;
+  }
+#endif
+
+  // If the switch stack last index is out of range, then it's an error - return
+  if (SpaceLeftOnSwitchStack()==0) return;
+
+  // Self test is a special case - there's no good way to debounce it
+  // so if it's already first on the stack, ignore it
+  if (switchNumber==SW_SELF_TEST_SWITCH) {
+    if (SwitchStackLast!=SwitchStackFirst && SwitchStack[SwitchStackFirst]==SW_SELF_TEST_SWITCH) return;
+  }
+
+  SwitchStack[SwitchStackLast] = switchNumber;
+#ifdef RPU_OS_USE_SWITCH_EVENT_TIMES
+  SwitchStackMicros[SwitchStackLast] = micros();
+#endif
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  if (coalesce) SwitchCoalescedCount[switchNumber] = 1;
+#endif
+  
+  SwitchStackLast += 1;
+  if (SwitchStackLast==SWITCH_STACK_SIZE) {
+    // If the end index is off the end, then wrap
+    SwitchStackLast = 0;
+  }
+}
+
+void RPU_PushToSwitchStack(byte switchNumber) {
+  PushToSwitchStack(switchNumber);
+}
+
+// Called by the interrupts with a column that has just been read.
+// Returns the column's debounced closures, and its opens in *validOpens.
+#ifndef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+byte DebounceSwitchColumn(byte switchCol, byte *validOpens) {
+  byte sample = SwitchesNow[switchCol];
+  byte stable = SwitchesStable[switchCol];
+
+  // Every switch closes on (off, on, on) and opens on (on, off) - with
+  // no hold-off, every stable closure was reported, so every open counts
+  byte validClosures = sample & SwitchesMinus1[switchCol] & ~stable;
+  *validOpens = ~sample & stable;
+  SwitchesStable[switchCol] = (stable | validClosures) & sample;
+#if (RPU_MPU_ARCHITECTURE>=10)
+  // (the Arch 1 column strobe keeps this)
+  SwitchesMinus1[switchCol] = sample;
+#endif
+  return validClosures;
+}
+#else
+byte DebounceSwitchColumn(byte switchCol, byte *validOpens) {
+  byte sample = SwitchesNow[switchCol];
+  byte changing = sample ^ SwitchesStable[switchCol];
+
+  // Count the samples in a row that differ from the stable state, and
+  // see which counts have reached the switch's samples to close (if the
+  // sample is closed) or to open
+  byte carry = changing;
+  byte reached = 0xFF;
+  for (byte plane=0; plane<SWITCH_SAMPLE_PLANES; plane++) {
+    byte count = SwitchChangeCount[plane][switchCol];
+    count = (count ^ carry) & changing;
+    carry &= SwitchChangeCount[plane][switchCol];
+    SwitchChangeCount[plane][switchCol] = count;
+    byte target = (sample & SwitchCloseSamples[plane][switchCol]) | (~sample & SwitchOpenSamples[plane][switchCol]);
+    reached &= ~(count ^ target);
+  }
+  byte flips = changing & reached;
+  SwitchesStable[switchCol] ^= flips;
+  for (byte plane=0; plane<SWITCH_SAMPLE_PLANES; plane++) SwitchChangeCount[plane][switchCol] &= ~flips;
+
+  // Closures don't count while a switch's hold-off is running, and a
+  // closure that counts starts it again
+  byte holding = 0;
+  for (byte plane=0; plane<SWITCH_HOLD_OFF_PLANES; plane++) holding |= SwitchHoldOff[plane][switchCol];
+  byte borrow = holding;
+  byte validClosures = flips & sample & ~holding;
+  for (byte plane=0; plane<SWITCH_HOLD_OFF_PLANES; plane++) {
+    byte holdOff = SwitchHoldOff[plane][switchCol];
+    byte counted = holdOff ^ borrow;
+    borrow &= ~holdOff;
+    SwitchHoldOff[plane][switchCol] = (counted & ~validClosures) | (SwitchRetrigger[plane][switchCol] & validClosures);
+  }
+
+  // (a closure dropped in the hold-off doesn't get an open either)
+  byte opens = flips & ~sample;
+  *validOpens = opens & SwitchClosureReported[switchCol];
+  SwitchClosureReported[switchCol] = (SwitchClosureReported[switchCol] & ~opens) | validClosures;
+  return validClosures;
+}
+#endif
+
+// Pushes a column's opens for the switches that report them
+void PushSwitchOpens(byte switchCol, byte validOpens) {
+  validOpens &= SwitchOpenEvents[switchCol];
+  if (!validOpens) return;
 
-  // Self test is a special case - there's no good way to debounce it
-  // so if it's already first on the stack, ignore it
-  if (switchNumber==SW_SELF_TEST_SWITCH) {
-    if (SwitchStackLast!=SwitchStackFirst && SwitchStack[SwitchStackFirst]==SW_SELF_TEST_SWITCH) return;
+  for (byte bitCount=0; bitCount<8; bitCount++) {
+    if (validOpens&0x01) PushToSwitchStack((switchCol*8 + bitCount) | SWITCH_STACK_OPENED);
+    validOpens = validOpens>>1;
   }
+}
 
-  SwitchStack[SwitchStackLast] = switchNumber;
-  
-  SwitchStackLast += 1;
-  if (SwitchStackLast==SWITCH_STACK_SIZE) {
-    // If the end index is off the end, then wrap
-    SwitchStackLast = 0;
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+void RPU_SetSwitchDebounce(byte switchNum, byte samplesToClose, byte samplesToOpen, unsigned short minRetriggerMillis) {
+  if (switchNum>=MAX_NUM_SWITCHES) return;
+  byte switchCol = switchNum/8;
+  byte switchBit = 1<<(switchNum%8);
+
+  if (samplesToClose<1) samplesToClose = 1;
+  if (samplesToClose>((1<<SWITCH_SAMPLE_PLANES)-1)) samplesToClose = (1<<SWITCH_SAMPLE_PLANES)-1;
+  if (samplesToOpen<1) samplesToOpen = 1;
+  if (samplesToOpen>((1<<SWITCH_SAMPLE_PLANES)-1)) samplesToOpen = (1<<SWITCH_SAMPLE_PLANES)-1;
+  // Scans of the column, rounded up
+  unsigned long retriggerScans = ((unsigned long)minRetriggerMillis*1000 + SWITCH_SCAN_MICROS - 1) / SWITCH_SCAN_MICROS;
+  if (retriggerScans>((1<<SWITCH_HOLD_OFF_PLANES)-1)) retriggerScans = (1<<SWITCH_HOLD_OFF_PLANES)-1;
+
+  // The interrupts read these planes
+  byte oldSREG = SREG;
+  cli();
+  for (byte plane=0; plane<SWITCH_SAMPLE_PLANES; plane++) {
+    if (samplesToClose & (1<<plane)) SwitchCloseSamples[plane][switchCol] |= switchBit;
+    else SwitchCloseSamples[plane][switchCol] &= ~switchBit;
+    if (samplesToOpen & (1<<plane)) SwitchOpenSamples[plane][switchCol] |= switchBit;
+    else SwitchOpenSamples[plane][switchCol] &= ~switchBit;
+  }
+  for (byte plane=0; plane<SWITCH_HOLD_OFF_PLANES; plane++) {
+    if (retriggerScans & (1<<plane)) SwitchRetrigger[plane][switchCol] |= switchBit;
+    else SwitchRetrigger[plane][switchCol] &= ~switchBit;
   }
+  SREG = oldSREG;
 }
+#endif
 
-void RPU_PushToSwitchStack(byte switchNumber) {
-  PushToSwitchStack(switchNumber);
+void RPU_SetSwitchOpenEvents(byte switchNum, boolean reportOpens) {
+  if (switchNum>=MAX_NUM_SWITCHES) return;
+  if (reportOpens) SwitchOpenEvents[switchNum/8] |= (1<<(switchNum%8));
+  else SwitchOpenEvents[switchNum/8] &= ~(1<<(switchNum%8));
+}
+
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+void RPU_SetSwitchCoalescing(byte switchNum, boolean coalesce) {
+  if (switchNum>=MAX_NUM_SWITCHES) return;
+  if (coalesce) SwitchCoalesce[switchNum/8] |= (1<<(switchNum%8));
+  else SwitchCoalesce[switchNum/8] &= ~(1<<(switchNum%8));
 }
+#endif
 
 
 byte RPU_PullFirstFromSwitchStack() {
+  // Opens are only returned by RPU_PullFirstSwitchEvent,
+  // so they're skipped here
+  while (SwitchStackFirst!=SwitchStackLast) {
+    byte retVal = SwitchStack[SwitchStackFirst];
+
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+    // The interrupts add to a coalesced closure's count until
+    // it comes off the stack, so this has to be atomic
+    byte oldSREG = SREG;
+    cli();
+    if (retVal<MAX_NUM_SWITCHES && SwitchCoalescedCount[retVal]>1) {
+      // Hand a coalesced closure out one at a time
+      SwitchCoalescedCount[retVal] -= 1;
+      SREG = oldSREG;
+      return retVal;
+    }
+    if (retVal<MAX_NUM_SWITCHES) SwitchCoalescedCount[retVal] = 0;
+    SwitchStackFirst += 1;
+    if (SwitchStackFirst>=SWITCH_STACK_SIZE) SwitchStackFirst = 0;
+    SREG = oldSREG;
+#else
+    SwitchStackFirst += 1;
+    if (SwitchStackFirst>=SWITCH_STACK_SIZE) SwitchStackFirst = 0;
+#endif
+
+    if (!(retVal & SWITCH_STACK_OPENED)) return retVal;
+  }
+
   // If first and last are equal, there's nothing on the stack
-  if (SwitchStackFirst==SwitchStackLast) return SWITCH_STACK_EMPTY;
+  return SWITCH_STACK_EMPTY;
+}
+
 
-  byte retVal = SwitchStack[SwitchStackFirst];
+boolean RPU_PullFirstSwitchEvent(RPUSwitchEvent *switchEvent) {
+  if (SwitchStackFirst==SwitchStackLast) return false;
+
+  // (the interrupt doesn't touch this entry until First moves past it)
+  byte stackEntry = SwitchStack[SwitchStackFirst];
+  switchEvent->switchNum = stackEntry & ~SWITCH_STACK_OPENED;
+  switchEvent->edge = (stackEntry & SWITCH_STACK_OPENED) ? RPU_SWITCH_EDGE_OPENED : RPU_SWITCH_EDGE_CLOSED;
+#ifdef RPU_OS_USE_SWITCH_EVENT_TIMES
+  switchEvent->detectedMicros = SwitchStackMicros[SwitchStackFirst];
+#else
+  switchEvent->detectedMicros = micros();
+#endif
+  switchEvent->count = 1;
 
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  // Take a coalesced closure's count and the entry together
+  byte oldSREG = SREG;
+  cli();
+  if (stackEntry<MAX_NUM_SWITCHES && SwitchCoalescedCount[stackEntry]) {
+    switchEvent->count = SwitchCoalescedCount[stackEntry];
+    SwitchCoalescedCount[stackEntry] = 0;
+  }
+  SwitchStackFirst += 1;
+  if (SwitchStackFirst>=SWITCH_STACK_SIZE) SwitchStackFirst = 0;
+  SREG = oldSREG;
+#else
   SwitchStackFirst += 1;
   if (SwitchStackFirst>=SWITCH_STACK_SIZE) SwitchStackFirst = 0;
+#endif
 
-  return retVal;
+  return true;
 }
 
 
@@ -1398,10 +2559,38 @@ byte RPU_GetDipSwitches(byte index) {
 }
 
 
+// With RPU_OS_USE_SWITCH_SOLENOID_TABLE, the switch interrupt uses a
+// copy of s_gameSwitchArray, so call this again after changing it. If a
+// switch is listed more than once, the first entry is used.
 void RPU_SetupGameSwitches(int s_numSwitches, int s_numPrioritySwitches, PlayfieldAndCabinetSwitch *s_gameSwitchArray) {
   NumGameSwitches = s_numSwitches;
   NumGamePrioritySwitches = s_numPrioritySwitches;
   GameSwitches = s_gameSwitchArray;
+
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_SWITCH_SOLENOID_TABLE)
+  byte switchSolenoid[MAX_NUM_SWITCHES];
+  byte switchSolenoidHoldTime[MAX_NUM_SWITCHES];
+  for (byte switchNum=0; switchNum<MAX_NUM_SWITCHES; switchNum++) {
+    switchSolenoid[switchNum] = 0;
+    switchSolenoidHoldTime[switchNum] = 0;
+  }
+  for (int switchCount=s_numSwitches-1; switchCount>=0 && s_gameSwitchArray; switchCount--) {
+    byte switchNum = s_gameSwitchArray[switchCount].switchNum;
+    if (switchNum>=MAX_NUM_SWITCHES) continue;
+    switchSolenoid[switchNum] = (s_gameSwitchArray[switchCount].solenoid & SWITCH_SOLENOID_MASK) | SWITCH_SOLENOID_IN_TABLE;
+    if (switchCount<s_numPrioritySwitches) switchSolenoid[switchNum] |= SWITCH_SOLENOID_PRIORITY;
+    switchSolenoidHoldTime[switchNum] = s_gameSwitchArray[switchCount].solenoidHoldTime;
+  }
+
+  // Swap it in without the switch interrupt seeing half a table
+  byte oldSREG = SREG;
+  cli();
+  for (byte switchNum=0; switchNum<MAX_NUM_SWITCHES; switchNum++) {
+    SwitchSolenoid[switchNum] = switchSolenoid[switchNum];
+    SwitchSolenoidHoldTime[switchNum] = switchSolenoidHoldTime[switchNum];
+  }
+  SREG = oldSREG;
+#endif
 }
 
 
@@ -1471,6 +2660,11 @@ void PushToFrontOfSolenoidStack(byte solenoidNumber, byte numPushes) {
   
 }
 
+byte FirstOnSolenoidStack() {
+  if (SolenoidStackFirst==SolenoidStackLast) return SOLENOID_STACK_EMPTY;
+  return SolenoidStack[SolenoidStackFirst];
+}
+
 byte PullFirstFromSolenoidStack() {
   // If first and last are equal, there's nothing on the stack
   if (SolenoidStackFirst==SolenoidStackLast) return SOLENOID_STACK_EMPTY;
@@ -1552,7 +2746,7 @@ boolean RPU_FireContinuousSolenoid(byte solBit, byte numCyclesToFire) {
 
 
 byte RPU_ReadContinuousSolenoids() {
-  return RPU_DataRead(ADDRESS_U11_B);
+  return RPU_ReadRegisterShadow(ADDRESS_U11_B);
 }
 
 
@@ -1579,8 +2773,8 @@ void RPU_SetContinuousSolenoid(boolean solOn, byte solNum) {
   else ContinuousSolenoidBits &= ~(1<<solNum);
 
   if (oldCont!=ContinuousSolenoidBits) {
-    byte origPortA = RPU_DataRead(PIA_SOLENOID_PORT_A);
-    byte origPortB = RPU_DataRead(PIA_SOLENOID_PORT_B);
+    byte origPortA = RPU_ReadRegisterShadow(PIA_SOLENOID_PORT_A);
+    byte origPortB = RPU_ReadRegisterShadow(PIA_SOLENOID_PORT_B);
     if (origPortA!=(ContinuousSolenoidBits&0xFF)) RPU_DataWrite(PIA_SOLENOID_PORT_A, (ContinuousSolenoidBits&0xFF));
     if (origPortB!=(ContinuousSolenoidBits/256)) RPU_DataWrite(PIA_SOLENOID_PORT_B, (ContinuousSolenoidBits/256));
   }
@@ -1607,6 +2801,22 @@ void RPU_EnableSolenoidStack() {
 }
 
 
+void RPU_SetSolenoidPowerBudget(byte maxPower) {
+  SolenoidPowerBudget = maxPower;
+}
+
+
+void RPU_SetSolenoidPower(byte solenoidNumber, byte power, byte groups) {
+  if (solenoidNumber>=RPU_NUM_SOLENOIDS) return;
+  // The interrupt reads both together
+  byte oldSREG = SREG;
+  cli();
+  SolenoidPower[solenoidNumber] = power;
+  SolenoidGroups[solenoidNumber] = groups;
+  SREG = oldSREG;
+}
+
+
 #endif 
 
 
@@ -1616,11 +2826,55 @@ void RPU_EnableSolenoidStack() {
 /******************************************************
  *   Display Handling Functions
  */
+#if (RPU_MPU_ARCHITECTURE<10)
+void RenderDisplayFrameDigit(byte digit) {
+  byte pulses[5];
+  byte numPulses = 0;
+  byte creditPulse = 0xFF;
+
+  for (byte displayCount=0; displayCount<5; displayCount++) {
+    // Blank digits get 0xF on the data lines
+    byte dataNibble = 0xF0;
+    if ((DisplayDigitEnable[displayCount]>>digit)&0x01) dataNibble = (DisplayDigits[displayCount][digit])<<4;
+
+    byte pulse;
+    for (pulse=0; pulse<numPulses; pulse++) {
+      if ((pulses[pulse]&0xF0)==dataNibble) break;
+    }
+    if (pulse==numPulses) {
+      pulses[pulse] = dataNibble | 0x0F;
+      numPulses += 1;
+    }
+
+    // Strobes for displays 0-3 are U10A:b0-b3 (low to latch)
+    if (displayCount<4) pulses[pulse] &= ~(0x01<<displayCount);
+    else creditPulse = pulse;
+  }
+
+  // The display interrupt could be part way through this digit
+  byte oldSREG = SREG;
+  cli();
+  for (byte pulse=0; pulse<numPulses; pulse++) DisplayFramePulses[digit][pulse] = pulses[pulse];
+  DisplayFrameNumPulses[digit] = numPulses;
+  DisplayFrameCreditPulse[digit] = creditPulse;
+  SREG = oldSREG;
+}
+
+void RenderDisplayFrame(byte digitMask) {
+  for (byte digit=0; digit<RPU_OS_NUM_DIGITS; digit++) {
+    if (digitMask & (0x01<<digit)) RenderDisplayFrameDigit(digit);
+  }
+}
+#endif
+
 #if (RPU_MPU_ARCHITECTURE<15)
 byte RPU_SetDisplay(int displayNumber, unsigned long value, boolean blankByMagnitude, byte minDigits, boolean showCommasByMagnitude) {
   if (displayNumber<0 || displayNumber>4) return 0;
 
   byte blank = 0x00;
+#if (RPU_MPU_ARCHITECTURE<10)
+  byte changedDigits = 0x00;
+#endif
 #if (RPU_MPU_ARCHITECTURE>=13)    
   byte commaBit = 0x01 << (2*displayNumber);
   if (!showCommasByMagnitude) {
@@ -1645,11 +2899,20 @@ byte RPU_SetDisplay(int displayNumber, unsigned long value, boolean blankByMagni
 #else
     (void)showCommasByMagnitude;
 #endif    
+#if (RPU_MPU_ARCHITECTURE<10)
+    if (DisplayDigits[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] != value%10) changedDigits |= (0x01<<((RPU_OS_NUM_DIGITS-1)-count));
+#endif
     DisplayDigits[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] = value%10;
     value /= 10;
   }
 
+#if (RPU_MPU_ARCHITECTURE<10)
+  if (blankByMagnitude) changedDigits |= (DisplayDigitEnable[displayNumber] ^ blank);
+#endif
   if (blankByMagnitude) DisplayDigitEnable[displayNumber] = blank;
+#if (RPU_MPU_ARCHITECTURE<10)
+  if (changedDigits) RenderDisplayFrame(changedDigits);
+#endif
 
   return blank;
 }
@@ -1673,6 +2936,7 @@ void RPU_SetDisplayCredits(int value, boolean displayOn, boolean showBothDigits)
   }
 
   DisplayDigitEnable[4] = enableMask;
+  RenderDisplayFrame(RPU_OS_MASK_SHIFT_2);
 }
 
 void RPU_SetDisplayBallInPlay(int value, boolean displayOn, boolean showBothDigits) {
@@ -1691,6 +2955,7 @@ void RPU_SetDisplayBallInPlay(int value, boolean displayOn, boolean showBothDigi
   }
 
   DisplayDigitEnable[4] = enableMask;
+  RenderDisplayFrame(RPU_OS_MASK_SHIFT_1);
 }
 
 #elif (RPU_MPU_ARCHITECTURE<15)
@@ -1791,7 +3056,13 @@ void RPU_SetDisplayBlank(int displayNumber, byte bitMask) {
   }
 #endif
     
+#if (RPU_MPU_ARCHITECTURE<10)
+  byte changedDigits = DisplayDigitEnable[displayNumber] ^ bitMask;
+  DisplayDigitEnable[displayNumber] = bitMask;
+  if (changedDigits) RenderDisplayFrame(changedDigits);
+#else
   DisplayDigitEnable[displayNumber] = bitMask;
+#endif
 }
 
 byte RPU_GetDisplayBlank(int displayNumber) {
@@ -1801,6 +3072,9 @@ byte RPU_GetDisplayBlank(int displayNumber) {
 
 #if defined(RPU_OS_ADJUSTABLE_DISPLAY_INTERRUPT)
 void RPU_SetDisplayRefreshConstant(int intervalConstant) {
+#if (RPU_MPU_ARCHITECTURE<10)
+  DisplayRefreshConstant = intervalConstant;
+#endif
   cli();
   //set timer1 interrupt at 1Hz
   TCCR1A = 0;// set entire TCCR1A register to 0
@@ -1818,6 +3092,90 @@ void RPU_SetDisplayRefreshConstant(int intervalConstant) {
 }
 #endif
 
+#if defined(RPU_OS_ADAPTIVE_DISPLAY_REFRESH)
+#if (RPU_MPU_ARCHITECTURE>=10) || !defined(RPU_OS_ADJUSTABLE_DISPLAY_INTERRUPT) || !defined(RPU_OS_USE_ISR_STATS)
+#error "RPU_OS_ADAPTIVE_DISPLAY_REFRESH needs Arch 1, RPU_OS_ADJUSTABLE_DISPLAY_INTERRUPT and RPU_OS_USE_ISR_STATS"
+#endif
+
+// How often the refresh is reconsidered (it moves one step at a time)
+#define ADAPTIVE_REFRESH_WINDOW_MS  250
+
+byte AdaptiveRefreshFastest = 0;
+byte AdaptiveRefreshSlowest = RPU_OS_SOFTWARE_DISPLAY_INTERRUPT_INTERVAL;
+unsigned short AdaptiveRefreshMinLoops = 0;
+byte AdaptiveRefreshMaxDuty = 10;
+unsigned long AdaptiveRefreshWindowStart = 0;
+unsigned long AdaptiveRefreshLoops = 0;
+unsigned long AdaptiveRefreshBusyAtStart = 0;
+
+void RPU_SetAdaptiveDisplayRefresh(byte fastestConstant, byte slowestConstant, unsigned short minLoopsPerSecond, byte maxDisplayDutyPercent) {
+  if (slowestConstant<fastestConstant) slowestConstant = fastestConstant;
+  AdaptiveRefreshFastest = fastestConstant;
+  AdaptiveRefreshSlowest = slowestConstant;
+  AdaptiveRefreshMinLoops = minLoopsPerSecond;
+  AdaptiveRefreshMaxDuty = maxDisplayDutyPercent;
+  AdaptiveRefreshWindowStart = 0;
+  if (fastestConstant==0) return;
+
+  if (DisplayRefreshConstant<fastestConstant) RPU_SetDisplayRefreshConstant(fastestConstant);
+  else if (DisplayRefreshConstant>slowestConstant) RPU_SetDisplayRefreshConstant(slowestConstant);
+}
+
+// Called from RPU_Update
+void UpdateAdaptiveDisplayRefresh(unsigned long currentTime) {
+  if (AdaptiveRefreshFastest==0) return;
+  AdaptiveRefreshLoops += 1;
+
+  byte oldSREG = SREG;
+  cli();
+  unsigned long displayBusy = ISRBusyMicros[RPU_ISR_TIMER];
+  SREG = oldSREG;
+
+  if (AdaptiveRefreshWindowStart==0) {
+    AdaptiveRefreshWindowStart = currentTime;
+    AdaptiveRefreshLoops = 0;
+    AdaptiveRefreshBusyAtStart = displayBusy;
+    return;
+  }
+  unsigned long windowMs = currentTime - AdaptiveRefreshWindowStart;
+  if (windowMs<ADAPTIVE_REFRESH_WINDOW_MS) return;
+
+  unsigned long loopsPerSecond = (AdaptiveRefreshLoops*1000)/windowMs;
+  if (loopsPerSecond>0xFFFF) loopsPerSecond = 0xFFFF;
+  AdaptiveRefreshLoopsPerSecond = loopsPerSecond;
+  // (in tenths of a percent)
+  unsigned long displayDuty = (displayBusy-AdaptiveRefreshBusyAtStart)/windowMs;
+
+  byte curConstant = DisplayRefreshConstant;
+  byte newConstant = curConstant;
+  if (loopsPerSecond<AdaptiveRefreshMinLoops || displayDuty>10*(unsigned long)AdaptiveRefreshMaxDuty) {
+    // Back off
+    if (curConstant<AdaptiveRefreshSlowest) newConstant = curConstant + 1;
+  } else if (curConstant>AdaptiveRefreshFastest) {
+    // Speed up if there's room for the extra interrupts - the
+    // loop rate needs some headroom so it doesn't just bounce back
+    unsigned long nextDuty = (displayDuty*(curConstant+1))/curConstant;
+    if (loopsPerSecond>=(AdaptiveRefreshMinLoops + AdaptiveRefreshMinLoops/16) && nextDuty<=10*(unsigned long)AdaptiveRefreshMaxDuty) {
+      newConstant = curConstant - 1;
+    }
+  }
+
+  if (newConstant!=curConstant) {
+    RPU_SetDisplayRefreshConstant(newConstant);
+    DisplayRefreshChanges += 1;
+    if (DEBUG_MESSAGES) {
+      char buf[128];
+      sprintf(buf, "* Display refresh %d -> %d (loops/s=%lu, display duty=%lu.%lu%%)\n", curConstant, newConstant, loopsPerSecond, displayDuty/10, displayDuty%10);
+      Serial.write(buf);
+    }
+  }
+
+  AdaptiveRefreshWindowStart = currentTime;
+  AdaptiveRefreshLoops = 0;
+  AdaptiveRefreshBusyAtStart = displayBusy;
+}
+#endif
+
 
 void RPU_SetDisplayFlash(int displayNumber, unsigned long value, unsigned long curTime, int period, byte minDigits) {
   // A period of zero toggles display every other time
@@ -1838,30 +3196,67 @@ void RPU_SetDisplayFlashCredits(unsigned long curTime, int period) {
     } else {
       DisplayDigitEnable[4] &= 0x39;
     }
+#if (RPU_MPU_ARCHITECTURE<10)
+    RenderDisplayFrame(0x06);
+#endif
   }
 }
 
 
 #if (RPU_MPU_ARCHITECTURE==15)
-byte RPU_SetDisplayText(int displayNumber, char *text, boolean blankByLength) {
+void SetAlphaGlyph(int displayNumber, byte digitNum, unsigned short glyph) {
+  // Segments 0-6 go out on port B and 7-13 on port A, and bit 7 of
+  // each port is the decimal point (A) and comma (B)
+  unsigned short portWord = ((glyph<<1)&0x7F00) | (glyph&0x007F);
+  if (glyph & RPU_GLYPH_DECIMAL) portWord |= 0x8000;
+  if (glyph & RPU_GLYPH_COMMA) portWord |= 0x0080;
+
+  byte oldSREG = SREG;
+  cli();
+  DisplayGlyphs[displayNumber][digitNum] = portWord;
+  SREG = oldSREG;
+}
+
+unsigned short AlphaGlyph(char character) {
+  byte index = (byte)character - 0x20;
+  if (index>=96) return 0;
+  return pgm_read_word(&FourteenSegmentASCII[index]);
+}
+
+byte RPU_SetDisplayText(int displayNumber, char *text, boolean blankByLength, boolean foldPunctuation) {
   if (displayNumber>1 || displayNumber<0) return 0;
-  byte stringLength = 0xff;
-  boolean writeSpace = false;
+  byte digitNum;
+  byte textIndex = 0;
   byte blank = 0;
   byte placeMask = 0x01;
 
-  for (stringLength=0; stringLength<RPU_OS_NUM_DIGITS; stringLength++) {
-    if (text[stringLength]==0) writeSpace = true;
-    if (!writeSpace) DisplayText[displayNumber][stringLength] = (byte)text[stringLength]-0x20;
-    else DisplayText[displayNumber][stringLength] = 0;
+  for (digitNum=0; digitNum<RPU_OS_NUM_DIGITS; digitNum++) {
+    unsigned short glyph = 0;
+    if (text[textIndex]!=0) {
+      glyph = AlphaGlyph(text[textIndex]);
+      textIndex += 1;
+      if (foldPunctuation && text[textIndex]=='.') {
+        glyph |= RPU_GLYPH_DECIMAL;
+        textIndex += 1;
+      } else if (foldPunctuation && text[textIndex]==',') {
+        glyph |= RPU_GLYPH_COMMA;
+        textIndex += 1;
+      }
+    }
+    SetAlphaGlyph(displayNumber, digitNum, glyph);
 
-    if (DisplayText[displayNumber][stringLength]) blank |= placeMask;
+    if (glyph) blank |= placeMask;
     placeMask *= 2;
   }
 
   if (blankByLength) DisplayDigitEnable[displayNumber] = blank;
 
-  return stringLength;
+  return digitNum;
+}
+
+void RPU_SetDisplayGlyph(int displayNumber, byte digitNum, unsigned short glyph) {
+  if (displayNumber>1 || displayNumber<0 || digitNum>=RPU_OS_NUM_DIGITS) return;
+  SetAlphaGlyph(displayNumber, digitNum, glyph);
 }
 
 // Architectures with alpha store numbers as 7-seg
@@ -1874,11 +3269,17 @@ byte RPU_SetDisplay(int displayNumber, unsigned long value, boolean blankByMagni
     blank = blank * 2;
     if (value!=0 || count<minDigits) {
       blank |= 1;
-      if (displayNumber/2) DisplayDigits[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] = SevenSegmentNumbers[value%10];
-      else DisplayText[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] = (value%10)+16;
+      if (displayNumber/2) {
+        DisplayDigits[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] = SevenSegmentNumbers[value%10];
+      } else {
+        // The alpha displays can show commas on the thousands and millions
+        unsigned short glyph = AlphaGlyph('0' + value%10);
+        if (showCommasByMagnitude && value && (count==3 || count==6)) glyph |= RPU_GLYPH_COMMA;
+        SetAlphaGlyph(displayNumber, (RPU_OS_NUM_DIGITS-1)-count, glyph);
+      }
     } else {
       if (displayNumber/2) DisplayDigits[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] = 0;
-      else DisplayText[displayNumber][(RPU_OS_NUM_DIGITS-1)-count] = 0;
+      else SetAlphaGlyph(displayNumber, (RPU_OS_NUM_DIGITS-1)-count, 0);
     }
     value /= 10;    
   }
@@ -1934,6 +3335,97 @@ void RPU_SetDimDivisor(byte level, byte divisor) {
 // left shift is iterative on Arduinos, so a bit array is suprisingly faster
 byte BitShiftValues[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
 
+#if (RPU_MPU_ARCHITECTURE<10)
+byte LampNibbleLowBits(byte nibbleNum) {
+#ifdef RPU_OS_USE_AUX_LAMPS
+  // Aux lamp nibbles carry their bank number instead
+  if (nibbleNum>=15) return nibbleNum-15;
+#else
+  (void)nibbleNum;
+#endif
+  return 0x0F;
+}
+
+#ifdef RPU_OS_USE_LAMP_NIBBLE_TABLES
+void UpdateLampNibbleOutput(byte lampCol) {
+  // (a set bit is a lamp that's off)
+  byte lampsOff[4];
+  lampsOff[0] = LampStates[lampCol];
+  lampsOff[1] = lampsOff[0] | LampDim1[lampCol];
+  lampsOff[2] = lampsOff[0] | LampDim2[lampCol];
+  lampsOff[3] = lampsOff[1] | LampDim2[lampCol];
+
+  // Lamp data goes out on the upper nibble of U10A
+  byte nibbleNum = lampCol*2;
+  byte lowBits0 = LampNibbleLowBits(nibbleNum);
+  byte lowBits1 = LampNibbleLowBits(nibbleNum+1);
+  for (byte dimPhase=0; dimPhase<4; dimPhase++) {
+    LampNibbleOutput[dimPhase][nibbleNum] = (lampsOff[dimPhase]<<4) | lowBits0;
+    LampNibbleOutput[dimPhase][nibbleNum+1] = (lampsOff[dimPhase]&0xF0) | lowBits1;
+  }
+}
+
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+void UpdateLampPlaneNibbleOutput(byte lampCol) {
+  byte nibbleNum = lampCol*2;
+  for (byte plane=0; plane<NUM_LAMP_BRIGHTNESS_PLANES; plane++) {
+    LampPlaneNibbleOutput[plane][nibbleNum] = LampPlaneOff[plane][lampCol]<<4;
+    LampPlaneNibbleOutput[plane][nibbleNum+1] = LampPlaneOff[plane][lampCol]&0xF0;
+  }
+}
+#endif
+#else
+// The U10A byte for a lamp nibble, worked out in the interrupt
+// (dimPhases has bit 0 set if dim 1 lamps are off, bit 1 for dim 2)
+inline byte LampNibbleOutputNow(byte nibbleNum, byte dimPhases) {
+  byte lampCol = nibbleNum/2;
+  // (a set bit is a lamp that's off)
+  byte lampsOff = LampStates[lampCol];
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+  lampsOff |= LampPlaneOff[LampBrightnessSlotPlane[LampBrightnessSlot]][lampCol];
+#endif
+  if (dimPhases&0x01) lampsOff |= LampDim1[lampCol];
+  if (dimPhases&0x02) lampsOff |= LampDim2[lampCol];
+
+  // Lamp data goes out on the upper nibble of U10A
+  if (nibbleNum&0x01) return (lampsOff&0xF0) | LampNibbleLowBits(nibbleNum);
+  return (lampsOff<<4) | LampNibbleLowBits(nibbleNum);
+}
+#endif
+#endif
+
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+// Lamps that are on show at brightness/15 (15 is full, the default).
+// Dimming and flashing still apply on top of this.
+void RPU_SetLampBrightness(int lampNum, byte brightness) {
+  if (lampNum>=RPU_MAX_LAMPS || lampNum<0) return;
+  if (brightness>15) brightness = 15;
+  byte lampCol = lampNum/8;
+  byte lampBit = BitShiftValues[lampNum%8];
+
+  for (byte plane=0; plane<NUM_LAMP_BRIGHTNESS_PLANES; plane++) {
+    if (brightness & BitShiftValues[plane]) LampPlaneOff[plane][lampCol] &= ~lampBit;
+    else LampPlaneOff[plane][lampCol] |= lampBit;
+  }
+
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+  UpdateLampPlaneNibbleOutput(lampCol);
+#endif
+}
+
+byte RPU_ReadLampBrightness(int lampNum) {
+  if (lampNum>=RPU_MAX_LAMPS || lampNum<0) return 0;
+  byte lampCol = lampNum/8;
+  byte lampBit = BitShiftValues[lampNum%8];
+
+  byte brightness = 0;
+  for (byte plane=0; plane<NUM_LAMP_BRIGHTNESS_PLANES; plane++) {
+    if (!(LampPlaneOff[plane][lampCol] & lampBit)) brightness |= BitShiftValues[plane];
+  }
+  return brightness;
+}
+#endif
+
 void RPU_SetLampState(int lampNum, byte s_lampState, byte s_lampDim, int s_lampFlashPeriod) {
   if (lampNum>=RPU_MAX_LAMPS || lampNum<0) return;
   byte lampRow = lampNum%8;
@@ -1967,6 +3459,9 @@ void RPU_SetLampState(int lampNum, byte s_lampState, byte s_lampDim, int s_lampF
     LampDim2[lampCol] &= ~lampBit;
   }
 
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+  UpdateLampNibbleOutput(lampCol);
+#endif
 }
 
 byte RPU_ReadLampState(int lampNum) {
@@ -1999,6 +3494,9 @@ void RPU_ApplyFlashToLamps(unsigned long curTime) {
   int curLampNum = 0;
 
   for (curLampByte=0; curLampByte<RPU_NUM_LAMP_BANKS; curLampByte++) {
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+    byte lampByteBefore = LampStates[curLampByte];
+#endif
     curLampBit = 0x01;
     for (byte curBit=0; curBit<8; curBit++) {
       if ( LampFlashPeriod[curLampNum]!=0 ) {
@@ -2013,6 +3511,9 @@ void RPU_ApplyFlashToLamps(unsigned long curTime) {
       curLampBit *= 2;
       curLampNum += 1;
     }
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+    if (LampStates[curLampByte]!=lampByteBefore) UpdateLampNibbleOutput(curLampByte);
+#endif
   }
 }
 
@@ -2044,11 +3545,23 @@ void RPU_ClearVariables() {
   // Reset switch stack
   SwitchStackFirst = 0;
   SwitchStackLast = 0;
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+  for (byte switchCount=0; switchCount<MAX_NUM_SWITCHES; switchCount++) SwitchCoalescedCount[switchCount] = 0;
+#endif
 
 #if (RPU_MPU_ARCHITECTURE > 9) 
   // Reset sound stack
   SoundStackFirst = 0;
   SoundStackLast = 0;
+
+  // Every coil counts as 1 against a budget of 1 (one at a time)
+  // until the machine sets them up
+  NumFiringSolenoids = 0;
+  SolenoidPowerBudget = 1;
+  for (byte count=0; count<RPU_NUM_SOLENOIDS; count++) {
+    SolenoidPower[count] = 1;
+    SolenoidGroups[count] = 0;
+  }
 #endif
 
   CurrentDisplayDigit = 0; 
@@ -2060,15 +3573,34 @@ void RPU_ClearVariables() {
     }
     DisplayDigitEnable[displayCount] = 0x00;
   }
+#if (RPU_MPU_ARCHITECTURE<10)
+  RenderDisplayFrame(RPU_OS_ALL_DIGITS_MASK);
+#endif
 #if (RPU_MPU_ARCHITECTURE>=13)  
   DisplayCommas = 0x00;
 #endif
+#if (RPU_MPU_ARCHITECTURE==15)
+  for (int displayCount=0; displayCount<2; displayCount++) {
+    for (int digitCount=0; digitCount<RPU_OS_NUM_DIGITS; digitCount++) {
+      DisplayGlyphs[displayCount][digitCount] = 0;
+    }
+  }
+#endif
 
   // Turn off all lamp states
   for (int lampBankCounter=0; lampBankCounter<RPU_NUM_LAMP_BANKS; lampBankCounter++) {
     LampStates[lampBankCounter] = 0xFF;
     LampDim1[lampBankCounter] = 0x00;
     LampDim2[lampBankCounter] = 0x00;
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+    for (byte plane=0; plane<NUM_LAMP_BRIGHTNESS_PLANES; plane++) LampPlaneOff[plane][lampBankCounter] = 0x00;
+#endif
+#if (RPU_MPU_ARCHITECTURE<10) && defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+    UpdateLampNibbleOutput(lampBankCounter);
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+    UpdateLampPlaneNibbleOutput(lampBankCounter);
+#endif
+#endif
   }
 
   for (int lampFlashCount=0; lampFlashCount<RPU_MAX_LAMPS; lampFlashCount++) {
@@ -2079,9 +3611,22 @@ void RPU_ClearVariables() {
   // (set them as closed so that if they're stuck they don't register as new events)
   byte switchCount;
   for (switchCount=0; switchCount<NUM_SWITCH_BYTES; switchCount++) {
-    SwitchesMinus2[switchCount] = 0xFF;
     SwitchesMinus1[switchCount] = 0xFF;
     SwitchesNow[switchCount] = 0xFF;
+    SwitchesStable[switchCount] = 0xFF;
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+    SwitchClosureReported[switchCount] = 0x00;
+    // Every switch starts with the default debounce and no hold-off
+    for (byte plane=0; plane<SWITCH_SAMPLE_PLANES; plane++) {
+      SwitchChangeCount[plane][switchCount] = 0x00;
+      SwitchCloseSamples[plane][switchCount] = (SWITCH_DEFAULT_CLOSE_SAMPLES & (1<<plane)) ? 0xFF : 0x00;
+      SwitchOpenSamples[plane][switchCount] = (SWITCH_DEFAULT_OPEN_SAMPLES & (1<<plane)) ? 0xFF : 0x00;
+    }
+    for (byte plane=0; plane<SWITCH_HOLD_OFF_PLANES; plane++) {
+      SwitchHoldOff[plane][switchCount] = 0x00;
+      SwitchRetrigger[plane][switchCount] = 0x00;
+    }
+#endif
   }
 
   for (byte count=0; count<TIMED_SOLENOID_STACK_SIZE; count++) {
@@ -2117,10 +3662,10 @@ void RPU_PlaySoundSAndT(byte soundByte) {
   byte oldSolenoidControlByte, soundLowerNibble, soundUpperNibble;
 
   // mask further zero-crossing interrupts during this 
-  noInterrupts();
+  MaskInterrupts();
 
   // Get the current value of U11:PortB - current solenoids
-  oldSolenoidControlByte = RPU_DataRead(ADDRESS_U11_B);
+  oldSolenoidControlByte = RPU_ReadRegisterShadow(ADDRESS_U11_B);
   soundLowerNibble = (oldSolenoidControlByte&0xF0) | (soundByte&0x0F); 
   soundUpperNibble = (oldSolenoidControlByte&0xF0) | (soundByte/16); 
     
@@ -2154,7 +3699,7 @@ void RPU_PlaySoundSAndT(byte soundByte) {
   // Put sound latch low
   RPU_DataWrite(ADDRESS_U11_B_CONTROL, 0x34);
 
-  interrupts();
+  UnmaskInterrupts();
 }
 #endif
 
@@ -2209,11 +3754,11 @@ void RPU_PlaySoundDash51(byte soundByte) {
   byte oldSolenoidControlByte, soundLowerNibble, displayWithSoundBit4, oldDisplayByte;
 
   // mask further zero-crossing interrupts during this 
-  noInterrupts();
+  MaskInterrupts();
 
   // Get the current value of U11:PortB - current solenoids
-  oldSolenoidControlByte = RPU_DataRead(ADDRESS_U11_B);
-  oldDisplayByte = RPU_DataRead(ADDRESS_U11_A);
+  oldSolenoidControlByte = RPU_ReadRegisterShadow(ADDRESS_U11_B);
+  oldDisplayByte = RPU_ReadRegisterShadow(ADDRESS_U11_A);
   soundLowerNibble = (oldSolenoidControlByte&0xF0) | (soundByte&0x0F); 
   displayWithSoundBit4 = oldDisplayByte;
   if (soundByte & 0x10) displayWithSoundBit4 |= 0x02;
@@ -2249,7 +3794,7 @@ void RPU_PlaySoundDash51(byte soundByte) {
   // Put sound latch low
   RPU_DataWrite(ADDRESS_U11_B_CONTROL, 0x34);
 
-  interrupts();
+  UnmaskInterrupts();
 }
 
 #endif
@@ -2289,22 +3834,17 @@ int SpaceLeftOnSoundStack() {
 }
 
 void RPU_PushToSoundStack(unsigned short soundNumber, byte numPushes) {  
-  // If the solenoid stack last index is out of range, then it's an error - return  
+  // If the stack is full (or the indices are out of range), return
   if (SpaceLeftOnSoundStack()==0) return;
   if (soundNumber<SoundLowerLimit || soundNumber>SoundUpperLimit) return;
-
-  for (int count=0; count<numPushes; count++) {
-    SoundStack[SoundStackLast] = soundNumber;
-    
-    SoundStackLast += 1;
-    if (SoundStackLast==SOUND_STACK_SIZE) {
-      // If the end index is off the end, then wrap
-      SoundStackLast = 0;
-    }
-    // If the stack is now full, return
-    if (SpaceLeftOnSoundStack()==0) return;
-  }
-
+  if (numPushes==0) return;
+
+  // The pushes are one entry (the entry is filled in before the
+  // interrupt can see it)
+  SoundStack[SoundStackLast].soundNumber = soundNumber;
+  SoundStack[SoundStackLast].passes = numPushes;
+  if (SoundStackLast==(SOUND_STACK_SIZE-1)) SoundStackLast = 0;
+  else SoundStackLast += 1;
 }
 
 
@@ -2314,10 +3854,14 @@ unsigned short PullFirstFromSoundStack() {
     return SOUND_STACK_EMPTY;
   }
   
-  unsigned short retVal = SoundStack[SoundStackFirst];
+  unsigned short retVal = SoundStack[SoundStackFirst].soundNumber;
 
-  SoundStackFirst += 1;
-  if (SoundStackFirst>=SOUND_STACK_SIZE) SoundStackFirst = 0;
+  // The entry comes off once its last pass is used
+  SoundStack[SoundStackFirst].passes -= 1;
+  if (SoundStack[SoundStackFirst].passes==0) {
+    SoundStackFirst += 1;
+    if (SoundStackFirst>=SOUND_STACK_SIZE) SoundStackFirst = 0;
+  }
 
   return retVal;
 }
@@ -2426,7 +3970,8 @@ boolean CheckForMPUClock() {
   unsigned long startTime = millis();
   int sawClockLow = 0;
   int sawClockHigh = 0;  
-  while (millis()<(startTime + 10)) {
+  // Stop as soon as the clock has been seen (the 10 ms only runs out when it's missing)
+  while (millis()<(startTime + 10) && (sawClockLow<=25 || sawClockHigh<=25)) {
     if (PING & 0x04) sawClockHigh += 1;
     else sawClockLow += 1;
   }
@@ -2458,6 +4003,170 @@ boolean CheckForMPUClock() {
   
   return false;
 }
+
+// With a 6802/8, CheckForMPUClock has to sample for the whole 10 ms,
+// so its answer is kept in EEPROM (along with the board rev and
+// architecture). WaitForBoardReady only keeps a cached answer if
+// the PIAs respond with the bus run that way.
+#define MPU_CLOCK_CACHE_SIGNATURE   0xC6
+#define MPU_CLOCK_CACHE_6802_OR_8   0
+#define MPU_CLOCK_CACHE_6800        1
+#define MPU_CLOCK_CACHE_EMPTY       0xFF
+
+byte MPUClockCache = MPU_CLOCK_CACHE_EMPTY;
+
+byte ReadMPUClockCache() {
+  byte signature = EEPROM.read(RPU_MPU_CLOCK_EEPROM_START_BYTE);
+  byte hardwareRev = EEPROM.read(RPU_MPU_CLOCK_EEPROM_START_BYTE+1);
+  byte architecture = EEPROM.read(RPU_MPU_CLOCK_EEPROM_START_BYTE+2);
+  byte clockType = EEPROM.read(RPU_MPU_CLOCK_EEPROM_START_BYTE+3);
+  byte checkByte = EEPROM.read(RPU_MPU_CLOCK_EEPROM_START_BYTE+4);
+
+  if (signature!=MPU_CLOCK_CACHE_SIGNATURE || hardwareRev!=RPU_OS_HARDWARE_REV || architecture!=RPU_MPU_ARCHITECTURE) return MPU_CLOCK_CACHE_EMPTY;
+  if (checkByte!=(byte)(signature ^ hardwareRev ^ architecture ^ clockType)) return MPU_CLOCK_CACHE_EMPTY;
+  if (clockType!=MPU_CLOCK_CACHE_6800 && clockType!=MPU_CLOCK_CACHE_6802_OR_8) return MPU_CLOCK_CACHE_EMPTY;
+  return clockType;
+}
+
+void WriteMPUClockCache(byte clockType) {
+  // Only write when it changes (EEPROM wears out)
+  if (ReadMPUClockCache()==clockType) return;
+  EEPROM.write(RPU_MPU_CLOCK_EEPROM_START_BYTE, MPU_CLOCK_CACHE_SIGNATURE);
+  EEPROM.write(RPU_MPU_CLOCK_EEPROM_START_BYTE+1, RPU_OS_HARDWARE_REV);
+  EEPROM.write(RPU_MPU_CLOCK_EEPROM_START_BYTE+2, RPU_MPU_ARCHITECTURE);
+  EEPROM.write(RPU_MPU_CLOCK_EEPROM_START_BYTE+3, clockType);
+  EEPROM.write(RPU_MPU_CLOCK_EEPROM_START_BYTE+4, MPU_CLOCK_CACHE_SIGNATURE ^ RPU_OS_HARDWARE_REV ^ RPU_MPU_ARCHITECTURE ^ clockType);
+}
+
+boolean DetectMPUClock() {
+  MPUClockCache = ReadMPUClockCache();
+  if (MPUClockCache==MPU_CLOCK_CACHE_EMPTY) return CheckForMPUClock();
+
+  // Leave the clock buffers the way CheckForMPUClock does
+  pinMode(RPU_DISABLE_PHI_FROM_MPU, OUTPUT);
+  digitalWrite(RPU_DISABLE_PHI_FROM_MPU, 1);
+  pinMode(RPU_DISABLE_PHI_FROM_CPU, OUTPUT);
+  digitalWrite(RPU_DISABLE_PHI_FROM_CPU, 1);
+  pinMode(RPU_PHI2_PIN, INPUT_PULLUP);
+  return (MPUClockCache==MPU_CLOCK_CACHE_6800) ? true : false;
+}
+#endif
+
+#ifndef RPU_OS_BOOT_TIMEOUT_IN_MILLISECONDS
+#define RPU_OS_BOOT_TIMEOUT_IN_MILLISECONDS   1000
+#endif
+
+// Time spent in each RPU_BOOT_PHASE_* of the last RPU_InitializeMPU
+unsigned long BootPhaseMicros[RPU_NUM_BOOT_PHASES];
+unsigned long BootPhaseStart;
+
+void EndBootPhase(byte phase) {
+  unsigned long now = micros();
+  BootPhaseMicros[phase] += now - BootPhaseStart;
+  BootPhaseStart = now;
+}
+
+unsigned long RPU_GetBootPhaseMicros(byte phase) {
+  if (phase>=RPU_NUM_BOOT_PHASES) return 0;
+  return BootPhaseMicros[phase];
+}
+
+#if (RPU_OS_HARDWARE_REV==4) || (RPU_OS_HARDWARE_REV>=101)
+// Polls for the MPU board to come out of reset instead of waiting
+// a fixed time. A 6800 clock has to be running (otherwise a bus
+// cycle would wait forever), and two PIA control registers have
+// to hold what's written to them. The second write and the first
+// read use different values, so a floating data bus can't pass.
+boolean PollForBoardReady(int probeAddress1, byte probeValue1, int probeAddress2, byte probeValue2) {
+  unsigned long startTime = millis();
+
+  if (UsesM6800Processor) {
+    unsigned long clockTimeout = RPU_OS_BOOT_TIMEOUT_IN_MILLISECONDS;
+#if (RPU_OS_HARDWARE_REV==102)
+    // A cached 6800 should show its clock as fast as CheckForMPUClock would
+    if (MPUClockCache!=MPU_CLOCK_CACHE_EMPTY) clockTimeout = 10;
+#endif
+    byte clockStates = 0;
+    while (clockStates!=0x03) {
+      if ((millis()-startTime)>=clockTimeout) return false;
+      clockStates |= (PING & 0x04) ? 0x01 : 0x02;
+    }
+  }
+
+  while ((millis()-startTime)<RPU_OS_BOOT_TIMEOUT_IN_MILLISECONDS) {
+    RPU_DataWrite(probeAddress1, probeValue1);
+    RPU_DataWrite(probeAddress2, probeValue2);
+    if ( (RPU_DataRead(probeAddress1)&0x3F)==probeValue1 && 
+         (RPU_DataRead(probeAddress2)&0x3F)==probeValue2 ) return true;
+  }
+
+  if (DEBUG_MESSAGES) Serial.write("* Timed out waiting for the MPU board\n");
+  return false;
+}
+
+boolean WaitForBoardReady(int probeAddress1, byte probeValue1, int probeAddress2, byte probeValue2) {
+  boolean boardReady = PollForBoardReady(probeAddress1, probeValue1, probeAddress2, probeValue2);
+
+#if (RPU_OS_HARDWARE_REV==102)
+  if (!boardReady && MPUClockCache!=MPU_CLOCK_CACHE_EMPTY) {
+    // The cached clock type didn't work (the CPU could have
+    // been changed), so detect it and try again
+    if (DEBUG_MESSAGES) Serial.write("* Cached clock type failed\n");
+    MPUClockCache = MPU_CLOCK_CACHE_EMPTY;
+    UsesM6800Processor = CheckForMPUClock();
+    if (UsesM6800Processor) pinMode(RPU_PHI2_PIN, INPUT);
+    else pinMode(RPU_PHI2_PIN, OUTPUT);
+    boardReady = PollForBoardReady(probeAddress1, probeValue1, probeAddress2, probeValue2);
+  }
+  if (boardReady) WriteMPUClockCache(UsesM6800Processor ? MPU_CLOCK_CACHE_6800 : MPU_CLOCK_CACHE_6802_OR_8);
+#endif
+
+  return boardReady;
+}
+#endif
+
+byte DetectedArchitecture = 0;
+
+byte RPU_GetDetectedArchitecture() {
+  return DetectedArchitecture;
+}
+
+#if (RPU_OS_HARDWARE_REV>=101)
+// Architecture mismatch detection: nothing is dispatched on the result,
+// init just boots the original code if this build is on the wrong board.
+// Bally/Stern boards have U10 at 0x88 (RAM on Williams boards), and
+// of the Williams boards only Sys 11 has the alpha display PIA at 0x2C00.
+// Sys 4/6 and Sys 7 have the same PIAs, so both come back as 11.
+#define PROBE_U10_A_CONTROL             0x89
+#define PROBE_SWITCH_CONTROL_A          0x3001
+#define PROBE_ALPHA_DISPLAY_CONTROL_A   0x2C01
+
+#if (RPU_MPU_ARCHITECTURE<10)
+#define BUILT_ARCHITECTURE_FAMILY       1
+#elif (RPU_MPU_ARCHITECTURE<15)
+#define BUILT_ARCHITECTURE_FAMILY       11
+#else
+#define BUILT_ARCHITECTURE_FAMILY       15
+#endif
+
+boolean ProbeForPIA(int controlAddress) {
+  // With CA2/CB2 as an output, bit 6 of a PIA control register
+  // always reads 0 -- RAM or an open bus gives back what was written
+  RPU_DataWrite(controlAddress, 0x78);
+  if ((RPU_DataRead(controlAddress)&0x7F)!=0x38) return false;
+  RPU_DataWrite(controlAddress, 0x7C);
+  if ((RPU_DataRead(controlAddress)&0x7F)!=0x3C) return false;
+  return true;
+}
+
+byte DetectMPUArchitecture() {
+  if (ProbeForPIA(PROBE_U10_A_CONTROL)) return 1;
+  if (ProbeForPIA(PROBE_SWITCH_CONTROL_A)) {
+    if (ProbeForPIA(PROBE_ALPHA_DISPLAY_CONTROL_A)) return 15;
+    return 11;
+  }
+  return 0;
+}
 #endif
  
 #if (RPU_MPU_ARCHITECTURE<10)
@@ -2465,83 +4174,87 @@ boolean CheckForMPUClock() {
 volatile int numberOfU10Interrupts = 0;
 volatile int numberOfU11Interrupts = 0;
 volatile byte InsideZeroCrossingInterrupt = 0;
+// Set when the display interrupt runs in the middle of a switch scan
+volatile boolean SwitchStrobeDisturbed = false;
+
+// Shortest low time for the display latch strobes
+#define DISPLAY_LATCH_PULSE_MICROSECONDS  16
 
 // INTERRUPT SERVICE ROUTINE
 // for ARCH 1 (B/S)
-ISR(TIMER1_COMPA_vect) {    //This is the interrupt request
+template <boolean M6800> void TimerInterruptService() {    //This is the interrupt request
+  RPU_BUS_SECTION_SAVE();
+  RPU_TRACE_PASS(BUS_TRACE_TIMER_PASS);
+  RPU_BUS_SECTION(RPU_BUS_SECTION_DISPLAY);
+  if (InsideZeroCrossingInterrupt) SwitchStrobeDisturbed = true;
+
   // Backup U10A
-  byte backupU10A = RPU_DataRead(ADDRESS_U10_A);
+  byte backupU10A = RPU_ReadRegisterShadow(ADDRESS_U10_A);
+  byte u10BControl = RPU_ReadRegisterShadow(ADDRESS_U10_B_CONTROL);
+  byte u10AControl = RPU_ReadRegisterShadow(ADDRESS_U10_A_CONTROL);
   
+  // Everything in here is a write, so do it all as one burst
+  RPU_BusBegin();
+
   // Disable lamp decoders & strobe latch
-  RPU_DataWrite(ADDRESS_U10_A, 0xFF);
-  RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) | 0x08);
-  RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) & 0xF7);
+  BusWrite<M6800>(ADDRESS_U10_A, 0xFF);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, u10BControl | 0x08);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, u10BControl & 0xF7);
 #ifdef RPU_OS_USE_AUX_LAMPS
   // Also park the aux lamp board 
-  RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL) | 0x08);
-  RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL) & 0xF7);    
-#endif
-
-  // Blank Displays
-  RPU_DataWrite(ADDRESS_U10_A_CONTROL, RPU_DataRead(ADDRESS_U10_A_CONTROL) & 0xF7);
-  // Set all 5 display latch strobes high
-  RPU_DataWrite(ADDRESS_U11_A, (RPU_DataRead(ADDRESS_U11_A)) | 0x01);
-  RPU_DataWrite(ADDRESS_U10_A, 0x0F);
+  byte u11AControl = RPU_ReadRegisterShadow(ADDRESS_U11_A_CONTROL);
+  BusWrite<M6800>(ADDRESS_U11_A_CONTROL, u11AControl | 0x08);
+  BusWrite<M6800>(ADDRESS_U11_A_CONTROL, u11AControl & 0xF7);    
+#endif
 
-  byte displayStrobeMask = 0x01;
   byte displayDigitsMask;
 #ifdef RPU_OS_USE_7_DIGIT_DISPLAYS          
   displayDigitsMask = (0x02<<CurrentDisplayDigit);
 #else
-  displayDigitsMask = RPU_DataRead(ADDRESS_U11_A) & 0x02;
+  displayDigitsMask = RPU_ReadRegisterShadow(ADDRESS_U11_A) & 0x02;
   displayDigitsMask |= (0x04<<CurrentDisplayDigit);
 #endif          
-      
-  // Write current display digits to 5 displays
-  for (int displayCount=0; displayCount<5; displayCount++) {
-
-    // The BCD for this digit is in b4-b7, and the display latch strobes are in b0-b3 (and U11A:b0)
-    byte displayDataByte = ((DisplayDigits[displayCount][CurrentDisplayDigit])<<4) | 0x0F;
-    byte displayEnable = ((DisplayDigitEnable[displayCount])>>CurrentDisplayDigit)&0x01;
-
-    // if this digit shouldn't be displayed, then set data lines to 0xFX so digit will be blank
-    if (!displayEnable) displayDataByte = 0xFF;
-
-    // Calculate which bit needs to be dropped
-    if (displayCount<4) {
-      displayDataByte &= ~(displayStrobeMask);
-    }
 
-    // Write out the digit & strobe (if it's 0-3)
-    // The current number to display is the upper nibble of displayDataByte, 
-    // and the lower nibble is the strobe lines for the four score displays.
-    // The strobe for the four score displays is high here because then the strobes
-    // are NOR'd with U10:CA2 (which mutes the signals during other actions).
-    // Only one strobe is low (from the above line. 
-    RPU_DataWrite(ADDRESS_U10_A, displayDataByte);
-    if (displayCount==4) {            
+  // Blank Displays
+  BusWrite<M6800>(ADDRESS_U10_A_CONTROL, u10AControl & 0xF7);
+  // Set all 5 display latch strobes high (U10A already has them high
+  // from the 0xFF above) and, with the displays blanked, enable the
+  // current digit
+  BusWrite<M6800>(ADDRESS_U11_A, displayDigitsMask | 0x01);
+
+  // Write current display digits to 5 displays. The bytes come ready
+  // from the display frame (see RenderDisplayFrameDigit) - the upper
+  // nibble is the number to display and the lower nibble is the strobe
+  // lines for the four score displays. The strobes are NOR'd with U10:CA2
+  // (which mutes the signals during other actions), so a low bit on the
+  // port latches that display. Displays showing the same number are
+  // latched by the same pulse.
+  volatile byte *framePulses = DisplayFramePulses[CurrentDisplayDigit];
+  byte numPulses = DisplayFrameNumPulses[CurrentDisplayDigit];
+  byte creditPulse = DisplayFrameCreditPulse[CurrentDisplayDigit];
+  byte nextDataByte = framePulses[0];
+  for (byte pulse=0; pulse<numPulses; pulse++) {
+    byte displayDataByte = nextDataByte;
+    BusWrite<M6800>(ADDRESS_U10_A, displayDataByte);
+    if (pulse==creditPulse) {
       // Strobe #5 latch on U11A:b0
-      RPU_DataWrite(ADDRESS_U11_A, displayDigitsMask & 0xFE);
+      BusWrite<M6800>(ADDRESS_U11_A, displayDigitsMask & 0xFE);
     }
+    byte pulseStart = TCNT0;
 
-    // Right now the "Display Latch Strobe" is high
+    // The strobe has to stay low (high on the port) for long enough, so
+    // set up what comes next while it's held instead of sitting in a delay
+    if (pulse+1<numPulses) nextDataByte = framePulses[pulse+1];
+    // (timer 0 counts 4 us, so wait for one count more than the time)
+    while ((byte)(TCNT0-pulseStart)<=(DISPLAY_LATCH_PULSE_MICROSECONDS/4));
 
     // Put the latch strobe bits back high (low on the port)
-    delayMicroseconds(16);
-    if (displayCount<4) {
-      displayDataByte |= 0x0F;
-      // Need to delay a little to make sure the strobe is low (high on the port) for long enough
-      RPU_DataWrite(ADDRESS_U10_A, displayDataByte);
-    } else {
-      RPU_DataWrite(ADDRESS_U11_A, displayDigitsMask | 0x01);        
+    if ((displayDataByte&0x0F)!=0x0F) BusWrite<M6800>(ADDRESS_U10_A, displayDataByte | 0x0F);
+    if (pulse==creditPulse) {
+      BusWrite<M6800>(ADDRESS_U11_A, displayDigitsMask | 0x01);        
     }
-    
-    displayStrobeMask *= 2;
   }
 
-  // While the data is being strobed, we need to enable the current digit
-  RPU_DataWrite(ADDRESS_U11_A, displayDigitsMask | 0x01);
-
   CurrentDisplayDigit = CurrentDisplayDigit + 1;
   if (CurrentDisplayDigit>=RPU_OS_NUM_DIGITS) {
     CurrentDisplayDigit = 0;
@@ -2549,12 +4262,34 @@ ISR(TIMER1_COMPA_vect) {    //This is the interrupt request
   }
 
   // Stop Blanking (current digits are all latched and ready)
-  RPU_DataWrite(ADDRESS_U10_A_CONTROL, RPU_DataRead(ADDRESS_U10_A_CONTROL) | 0x08);
+  BusWrite<M6800>(ADDRESS_U10_A_CONTROL, u10AControl | 0x08);
 
   // Restore 10A from backup
-  RPU_DataWrite(ADDRESS_U10_A, backupU10A);    
+  BusWrite<M6800>(ADDRESS_U10_A, backupU10A);    
+  RPU_BusEnd();
+  RPU_TRACE_PASS_END(BUS_TRACE_TIMER_PASS);
+  RPU_BUS_SECTION_RESTORE();
+
+}
 
+#if (RPU_OS_HARDWARE_REV==102)
+// Set to the 6800 or 6802/8 build of the handler in RPU_HookInterrupts
+void (*TimerInterruptHandler)() = TimerInterruptService<BUILT_FOR_M6800>;
+
+ISR(TIMER1_COMPA_vect) {
+  RPU_ISR_STATS_TIMER_LATE(((unsigned long)TCNT1)*64 /* counts are 64 us (/1024) */);
+  RPU_ISR_STATS_BEGIN();
+  TimerInterruptHandler();
+  RPU_ISR_STATS_END(RPU_ISR_TIMER);
+}
+#else
+ISR(TIMER1_COMPA_vect) {
+  RPU_ISR_STATS_TIMER_LATE(((unsigned long)TCNT1)*64 /* counts are 64 us (/1024) */);
+  RPU_ISR_STATS_BEGIN();
+  TimerInterruptService<BUILT_FOR_M6800>();
+  RPU_ISR_STATS_END(RPU_ISR_TIMER);
 }
+#endif
 
 /*
 ISR(TIMER1_COMPA_vect) {    //This is the interrupt request
@@ -2636,291 +4371,433 @@ ISR(TIMER1_COMPA_vect) {    //This is the interrupt request
 */
 
 
-void InterruptService3() {
-  byte u10AControl = RPU_DataRead(ADDRESS_U10_A_CONTROL);
-  if (u10AControl & 0x80) {
-    // self test switch
-    if (RPU_DataRead(ADDRESS_U10_A_CONTROL) & 0x80) PushToSwitchStack(SW_SELF_TEST_SWITCH);
-    RPU_DataRead(ADDRESS_U10_A);
-  }
-
-  // If we get a weird interupt from U11B, clear it
-  byte u11BControl = RPU_DataRead(ADDRESS_U11_B_CONTROL);
-  if (u11BControl & 0x80) {
-    RPU_DataRead(ADDRESS_U11_B);    
-  }
-
-  byte u11AControl = RPU_DataRead(ADDRESS_U11_A_CONTROL);
-  byte u10BControl = RPU_DataRead(ADDRESS_U10_B_CONTROL);
-
-  // If the interrupt bit on the display interrupt is on, do the display refresh
-  if (u11AControl & 0x80) {
-    RPU_DataRead(ADDRESS_U11_A);
-    numberOfU11Interrupts+=1;
-  }
-
-  // If the IRQ bit of U10BControl is set, do the Zero-crossing interrupt handler
-  if ((u10BControl & 0x80) && (InsideZeroCrossingInterrupt==0)) {
-    InsideZeroCrossingInterrupt = InsideZeroCrossingInterrupt + 1;
-
-    byte u10BControlLatest = RPU_DataRead(ADDRESS_U10_B_CONTROL);
+// Switch columns are strobed one timer 2 tick apart (the old code
+// busy-waited the same time inside the zero-crossing interrupt).
+// Timer 2 counts at 16 MHz / 64 = 4 us. The solenoids and lamps
+// follow the last column, the same time after the zero crossing as
+// before, so the lamp SCRs still see the voltage they need.
+#define SWITCH_SCAN_TICK_MICROSECONDS   (RPU_OS_SWITCH_DELAY_IN_MICROSECONDS + RPU_OS_TIMING_LOOP_PADDING_IN_MICROSECONDS)
+#define SWITCH_SCAN_TIMER_COUNTS        (SWITCH_SCAN_TICK_MICROSECONDS/4)
+#if (SWITCH_SCAN_TIMER_COUNTS>256)
+#error "RPU_OS_SWITCH_DELAY_IN_MICROSECONDS + RPU_OS_TIMING_LOOP_PADDING_IN_MICROSECONDS has to be 1024 or less"
+#endif
 
-    // Backup contents of U10A
-    byte backup10A = RPU_DataRead(ADDRESS_U10_A);
+volatile byte SwitchScanColumn = 0;
+byte SwitchScanBackupU10A;
+byte SwitchScanU10BControl;
 
-    // Latch 0xFF separately without interrupt clear
-    RPU_DataWrite(ADDRESS_U10_A, 0xFF);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) | 0x08);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) & 0xF7);
-    // Read U10B to clear interrupt
-    RPU_DataRead(ADDRESS_U10_B);
+inline void StartSwitchScanTimer() {
+  TCNT2 = 0;
+  TIFR2 = (1<<OCF2A);
+  TIMSK2 = (1<<OCIE2A);
+  TCCR2B = (1<<CS22);
+}
 
-    // Turn off U10BControl interrupts
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, 0x30);
+inline void StopSwitchScanTimer() {
+  TCCR2B = 0;
+  TIMSK2 = 0;
+}
 
-    // Copy old switch values
-    byte switchCount;
-    byte startingClosures;
-    byte validClosures;
-    for (switchCount=0; switchCount<NUM_SWITCH_BYTES; switchCount++) {
-      SwitchesMinus2[switchCount] = SwitchesMinus1[switchCount];
-      SwitchesMinus1[switchCount] = SwitchesNow[switchCount];
+template <boolean M6800> void StrobeSwitchColumn(byte switchCount) {
+  // Copy old switch values
+  SwitchesMinus1[switchCount] = SwitchesNow[switchCount];
 
-      // Enable switch strobe
+  // Enable switch strobe
 #if defined(RPU_USE_EXTENDED_SWITCHES_ON_PB4) or defined(RPU_USE_EXTENDED_SWITCHES_ON_PB7)
-      if (switchCount<NUM_SWITCH_BYTES_ON_U10_PORT_A) {
-        RPU_DataWrite(ADDRESS_U10_A, 0x01<<switchCount);
-      } else {
-        RPU_SetContinuousSolenoidBit(true, ST5_CONTINUOUS_SOLENOID_BIT);
-      }
+  if (switchCount<NUM_SWITCH_BYTES_ON_U10_PORT_A) {
+    DataWrite<M6800>(ADDRESS_U10_A, 0x01<<switchCount);
+  } else {
+    RPU_SetContinuousSolenoidBit(true, ST5_CONTINUOUS_SOLENOID_BIT);
+  }
+  RPU_BusBegin();
 #else       
-      RPU_DataWrite(ADDRESS_U10_A, 0x01<<switchCount);
+  RPU_BusBegin();
+  BusWrite<M6800>(ADDRESS_U10_A, 0x01<<switchCount);
 #endif        
 
-      // Turn off U10:CB2 if it's on (because it strobes the last bank of dip switches
-      RPU_DataWrite(ADDRESS_U10_B_CONTROL, 0x34);
-
-      // Delay for switch capacitors to charge
-      delayMicroseconds(RPU_OS_SWITCH_DELAY_IN_MICROSECONDS);
-      
-      // Read the switches
-      SwitchesNow[switchCount] = RPU_DataRead(ADDRESS_U10_B);
-
-      //Unset the strobe
-      RPU_DataWrite(ADDRESS_U10_A, 0x00);
-#if defined(RPU_USE_EXTENDED_SWITCHES_ON_PB4) or defined(RPU_USE_EXTENDED_SWITCHES_ON_PB7)
-      RPU_SetContinuousSolenoidBit(false, ST5_CONTINUOUS_SOLENOID_BIT);
-#endif 
+  // Turn off U10:CB2 if it's on (because it strobes the last bank of dip switches
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x34);
+  RPU_BusEnd();
+}
 
-      // Some switches need to trigger immediate closures (bumpers & slings)
-      startingClosures = (SwitchesNow[switchCount]) & (~SwitchesMinus1[switchCount]);
-      boolean immediateSolenoidFired = false;
-      // If one of the switches is starting to close (off, on)
-      if (startingClosures) {
-        // Loop on bits of switch byte
-        for (byte bitCount=0; bitCount<8 && immediateSolenoidFired==false; bitCount++) {
-          // If this switch bit is closed
-          if (startingClosures&0x01) {
-            byte startingSwitchNum = switchCount*8 + bitCount;
-            // Loop on immediate switch data
-            for (int immediateSwitchCount=0; immediateSwitchCount<NumGamePrioritySwitches && immediateSolenoidFired==false; immediateSwitchCount++) {
-              // If this switch requires immediate action
-              if (GameSwitches && startingSwitchNum==GameSwitches[immediateSwitchCount].switchNum) {
-                // Start firing this solenoid (just one until the closure is validate
-                PushToFrontOfSolenoidStack(GameSwitches[immediateSwitchCount].solenoid, 1);
-                immediateSolenoidFired = true;
-              }
-            }
+void ProcessSwitchColumn(byte switchCount) {
+  byte startingClosures;
+  byte validClosures;
+
+  // Some switches need to trigger immediate closures (bumpers & slings)
+  startingClosures = (SwitchesNow[switchCount]) & (~SwitchesMinus1[switchCount]);
+#ifdef RPU_OS_USE_SWITCH_SOLENOID_TABLE
+  // If one of the switches is starting to close (off, on)
+  if (startingClosures) {
+    // Loop on bits of switch byte
+    for (byte bitCount=0; bitCount<8; bitCount++) {
+      // If this switch bit is closed
+      if (startingClosures&0x01) {
+        byte switchSolenoid = SwitchSolenoid[switchCount*8 + bitCount];
+        // If this switch requires immediate action
+        if (switchSolenoid & SWITCH_SOLENOID_PRIORITY) {
+          // Start firing this solenoid (just one until the closure is validate
+          PushToFrontOfSolenoidStack(switchSolenoid & SWITCH_SOLENOID_MASK, 1);
+          break;
+        }
+      }
+      startingClosures = startingClosures>>1;
+    }
+  }
+#else
+  boolean immediateSolenoidFired = false;
+  // If one of the switches is starting to close (off, on)
+  if (startingClosures) {
+    // Loop on bits of switch byte
+    for (byte bitCount=0; bitCount<8 && immediateSolenoidFired==false; bitCount++) {
+      // If this switch bit is closed
+      if (startingClosures&0x01) {
+        byte startingSwitchNum = switchCount*8 + bitCount;
+        // Loop on immediate switch data
+        for (int immediateSwitchCount=0; immediateSwitchCount<NumGamePrioritySwitches && immediateSolenoidFired==false; immediateSwitchCount++) {
+          // If this switch requires immediate action
+          if (GameSwitches && startingSwitchNum==GameSwitches[immediateSwitchCount].switchNum) {
+            // Start firing this solenoid (just one until the closure is validate
+            PushToFrontOfSolenoidStack(GameSwitches[immediateSwitchCount].solenoid, 1);
+            immediateSolenoidFired = true;
           }
-          startingClosures = startingClosures>>1;
         }
       }
+      startingClosures = startingClosures>>1;
+    }
+  }
+  immediateSolenoidFired = false;
+#endif
 
-      immediateSolenoidFired = false;
-      validClosures = (SwitchesNow[switchCount] & SwitchesMinus1[switchCount]) & ~SwitchesMinus2[switchCount];
-      // If there is a valid switch closure (off, on, on)
-      if (validClosures) {
-        // Loop on bits of switch byte
-        for (byte bitCount=0; bitCount<8; bitCount++) {
-          // If this switch bit is closed
-          if (validClosures&0x01) {
-            byte validSwitchNum = switchCount*8 + bitCount;
-            // Loop through all switches and see what's triggered
-            for (int validSwitchCount=0; validSwitchCount<NumGameSwitches; validSwitchCount++) {
-
-              // If we've found a valid closed switch
-              if (GameSwitches && GameSwitches[validSwitchCount].switchNum==validSwitchNum) {
-
-                // If we're supposed to trigger a solenoid, then do it
-                if (GameSwitches[validSwitchCount].solenoid!=SOL_NONE) {
-                  if (validSwitchCount<NumGamePrioritySwitches && immediateSolenoidFired==false) {
-                    PushToFrontOfSolenoidStack(GameSwitches[validSwitchCount].solenoid, GameSwitches[validSwitchCount].solenoidHoldTime);
-                  } else {
-                    RPU_PushToSolenoidStack(GameSwitches[validSwitchCount].solenoid, GameSwitches[validSwitchCount].solenoidHoldTime);
-                  }
-                } // End if this is a real solenoid
-              } // End if this is a switch in the switch table
-            } // End loop on switches in switch table
-            // Push this switch to the game rules stack
-            PushToSwitchStack(validSwitchNum);
+  byte validOpens;
+  validClosures = DebounceSwitchColumn(switchCount, &validOpens);
+  // If there is a valid switch closure
+  if (validClosures) {
+    // Loop on bits of switch byte
+    for (byte bitCount=0; bitCount<8; bitCount++) {
+      // If this switch bit is closed
+      if (validClosures&0x01) {
+        byte validSwitchNum = switchCount*8 + bitCount;
+#ifdef RPU_OS_USE_SWITCH_SOLENOID_TABLE
+        byte switchSolenoid = SwitchSolenoid[validSwitchNum];
+
+        // If we're supposed to trigger a solenoid, then do it
+        if ((switchSolenoid & SWITCH_SOLENOID_IN_TABLE) && (switchSolenoid & SWITCH_SOLENOID_MASK)!=SOL_NONE) {
+          if (switchSolenoid & SWITCH_SOLENOID_PRIORITY) {
+            PushToFrontOfSolenoidStack(switchSolenoid & SWITCH_SOLENOID_MASK, SwitchSolenoidHoldTime[validSwitchNum]);
+          } else {
+            RPU_PushToSolenoidStack(switchSolenoid & SWITCH_SOLENOID_MASK, SwitchSolenoidHoldTime[validSwitchNum]);
           }
-          validClosures = validClosures>>1;
-        }        
+        } // End if this is a real solenoid
+#else
+        // Loop through all switches and see what's triggered
+        for (int validSwitchCount=0; validSwitchCount<NumGameSwitches; validSwitchCount++) {
+
+          // If we've found a valid closed switch
+          if (GameSwitches && GameSwitches[validSwitchCount].switchNum==validSwitchNum) {
+
+            // If we're supposed to trigger a solenoid, then do it
+            if (GameSwitches[validSwitchCount].solenoid!=SOL_NONE) {
+              if (validSwitchCount<NumGamePrioritySwitches && immediateSolenoidFired==false) {
+                PushToFrontOfSolenoidStack(GameSwitches[validSwitchCount].solenoid, GameSwitches[validSwitchCount].solenoidHoldTime);
+              } else {
+                RPU_PushToSolenoidStack(GameSwitches[validSwitchCount].solenoid, GameSwitches[validSwitchCount].solenoidHoldTime);
+              }
+            } // End if this is a real solenoid
+          } // End if this is a switch in the switch table
+        } // End loop on switches in switch table
+#endif
+        // Push this switch to the game rules stack
+        PushToSwitchStack(validSwitchNum);
       }
+      validClosures = validClosures>>1;
+    }        
+  }
 
-      // There are no port reads or writes for the rest of the loop, 
-      // so we can allow the display interrupt to fire
-      interrupts();
-      
-      // Wait so total delay will allow lamp SCRs to get to the proper voltage
-      delayMicroseconds(RPU_OS_TIMING_LOOP_PADDING_IN_MICROSECONDS);
-      
-      noInterrupts();
-    }
-    RPU_DataWrite(ADDRESS_U10_A, backup10A);
+  PushSwitchOpens(switchCount, validOpens);
+}
 
-    if (NumCyclesBeforeRevertingSolenoidByte!=0) {
-      NumCyclesBeforeRevertingSolenoidByte -= 1;
-      if (NumCyclesBeforeRevertingSolenoidByte==0) {
-        CurrentSolenoidByte |= RevertSolenoidBit;
-        RevertSolenoidBit = 0x00;
-      }
+// Runs after the last column is read: solenoids, lamps, and
+// the zero-crossing interrupt is turned back on
+template <boolean M6800> void FinishZeroCrossing() {
+  DataWrite<M6800>(ADDRESS_U10_A, SwitchScanBackupU10A);
+
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SOLENOIDS);
+  if (NumCyclesBeforeRevertingSolenoidByte!=0) {
+    NumCyclesBeforeRevertingSolenoidByte -= 1;
+    if (NumCyclesBeforeRevertingSolenoidByte==0) {
+      CurrentSolenoidByte |= RevertSolenoidBit;
+      RevertSolenoidBit = 0x00;
     }
+  }
 
 #ifdef RPU_OS_USE_DASH32
-    // mask out sound E line
-    byte curDisplayDigitEnableByte = RPU_DataRead(ADDRESS_U11_A);
-    RPU_DataWrite(ADDRESS_U11_A, curDisplayDigitEnableByte | 0x02);
+  // mask out sound E line
+  byte curDisplayDigitEnableByte = RPU_ReadRegisterShadow(ADDRESS_U11_A);
+  DataWrite<M6800>(ADDRESS_U11_A, curDisplayDigitEnableByte | 0x02);
 #endif    
 
-    // If we need to turn off momentary solenoids, do it first
-    byte momentarySolenoidAtStart = PullFirstFromSolenoidStack();
-    if (momentarySolenoidAtStart!=SOLENOID_STACK_EMPTY) {
-      CurrentSolenoidByte = (CurrentSolenoidByte&0xF0) | momentarySolenoidAtStart;
-      RPU_DataWrite(ADDRESS_U11_B, CurrentSolenoidByte);
+  // If we need to turn off momentary solenoids, do it first
+  byte momentarySolenoidAtStart = PullFirstFromSolenoidStack();
+  if (momentarySolenoidAtStart!=SOLENOID_STACK_EMPTY) {
+    CurrentSolenoidByte = (CurrentSolenoidByte&0xF0) | momentarySolenoidAtStart;
+    DataWrite<M6800>(ADDRESS_U11_B, CurrentSolenoidByte);
 #ifdef RPU_OS_USE_DASH32
-      // Raise CB2 so we don't unset the solenoid we just set
-      RPU_DataWrite(ADDRESS_U11_B_CONTROL, 0x3C);
-      // Mask off sound lines
-      RPU_DataWrite(ADDRESS_U11_B, CurrentSolenoidByte | SOL_NONE);
-      // Put CB2 back low
-      RPU_DataWrite(ADDRESS_U11_B_CONTROL, 0x34);
-      // Put solenoids back again
-      RPU_DataWrite(ADDRESS_U11_B, CurrentSolenoidByte);
+    // Raise CB2 so we don't unset the solenoid we just set
+    DataWrite<M6800>(ADDRESS_U11_B_CONTROL, 0x3C);
+    // Mask off sound lines
+    DataWrite<M6800>(ADDRESS_U11_B, CurrentSolenoidByte | SOL_NONE);
+    // Put CB2 back low
+    DataWrite<M6800>(ADDRESS_U11_B_CONTROL, 0x34);
+    // Put solenoids back again
+    DataWrite<M6800>(ADDRESS_U11_B, CurrentSolenoidByte);
 #endif    
-    } else {
-      CurrentSolenoidByte = (CurrentSolenoidByte&0xF0) | SOL_NONE;
-      RPU_DataWrite(ADDRESS_U11_B, CurrentSolenoidByte);
-    }
+  } else {
+    CurrentSolenoidByte = (CurrentSolenoidByte&0xF0) | SOL_NONE;
+    DataWrite<M6800>(ADDRESS_U11_B, CurrentSolenoidByte);
+  }
 
 #ifdef RPU_OS_USE_DASH32
-    // put back U11 A without E line
-    RPU_DataWrite(ADDRESS_U11_A, curDisplayDigitEnableByte);
+  // put back U11 A without E line
+  DataWrite<M6800>(ADDRESS_U11_A, curDisplayDigitEnableByte);
 #endif    
 
-    for (int lampByteCount=0; lampByteCount<8; lampByteCount++) {
-      for (byte nibbleCount=0; nibbleCount<2; nibbleCount++) {
-        
-        // We skip iteration number 16 because the last position is to park the lamps
-        if (lampByteCount==(7) && nibbleCount) continue;
-        
-        byte lampData = 0xF0 + (lampByteCount*2) + nibbleCount;
+  RPU_BUS_SECTION(RPU_BUS_SECTION_LAMPS);
+  byte dimPhases = (LampDimPhase1?1:0) | (LampDimPhase2?2:0);
+#ifdef RPU_OS_USE_LAMP_NIBBLE_TABLES
+  // Lamp outputs for this dim phase
+  volatile byte *lampNibbles = LampNibbleOutput[dimPhases];
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+  // and the lamps this brightness plane turns off
+  volatile byte *planeNibbles = LampPlaneNibbleOutput[LampBrightnessSlotPlane[LampBrightnessSlot]];
+#endif
+#endif
 
-        interrupts();
-        RPU_DataWrite(ADDRESS_U10_A, 0xFF);
-        noInterrupts();
+  // We skip nibble number 16 because the last position is to park the lamps
+  for (byte nibbleNum=0; nibbleNum<15; nibbleNum++) {
+    interrupts();
+    DataWrite<M6800>(ADDRESS_U10_A, 0xFF);
+    noInterrupts();
 
-        // Latch address & strobe
-        RPU_DataWrite(ADDRESS_U10_A, lampData);
+    // Latch address & strobe
+    RPU_BusBegin();
+    BusWrite<M6800>(ADDRESS_U10_A, 0xF0 | nibbleNum);
 #ifdef RPU_SLOW_DOWN_LAMP_STROBE      
-        delayMicroseconds(2);
+    delayMicroseconds(2);
 #endif      
 
-        RPU_DataWrite(ADDRESS_U10_B_CONTROL, 0x38);
+    BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x38);
 #ifdef RPU_SLOW_DOWN_LAMP_STROBE      
-        delayMicroseconds(2);
+    delayMicroseconds(2);
 #endif      
 
-        RPU_DataWrite(ADDRESS_U10_B_CONTROL, 0x30);
+    BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x30);
 #ifdef RPU_SLOW_DOWN_LAMP_STROBE      
-        delayMicroseconds(2);
+    delayMicroseconds(2);
 #endif      
 
-        // Use the inhibit lines to set the actual data to the lamp SCRs 
-        // (here, we don't care about the lower nibble because the address was already latched)
-        byte nibbleOffset = (nibbleCount)?1:16;
-        byte lampOutput = (LampStates[lampByteCount] * nibbleOffset);
-        // Every other time through the cycle, we OR in the dim variable
-        // in order to dim those lights
-        if (numberOfU10Interrupts%DimDivisor1) lampOutput |= (LampDim1[lampByteCount] * nibbleOffset);
-        if (numberOfU10Interrupts%DimDivisor2) lampOutput |= (LampDim2[lampByteCount] * nibbleOffset);
-
-        RPU_DataWrite(ADDRESS_U10_A, lampOutput | 0x0F);
+    // Use the inhibit lines to set the actual data to the lamp SCRs 
+    // (here, we don't care about the lower nibble because the address was already latched)
+#if defined(RPU_OS_USE_LAMP_NIBBLE_TABLES) && defined(RPU_OS_USE_LAMP_BRIGHTNESS)
+    BusWrite<M6800>(ADDRESS_U10_A, lampNibbles[nibbleNum] | planeNibbles[nibbleNum]);
+#elif defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+    BusWrite<M6800>(ADDRESS_U10_A, lampNibbles[nibbleNum]);
+#else
+    BusWrite<M6800>(ADDRESS_U10_A, LampNibbleOutputNow(nibbleNum, dimPhases));
+#endif
+    RPU_BusEnd();
 #ifdef RPU_SLOW_DOWN_LAMP_STROBE      
-        delayMicroseconds(2);
+    delayMicroseconds(2);
 #endif      
-      } // end loop on nibble
-    } // end loop on lamp bytes
+  }
 
 
 #ifdef RPU_OS_USE_AUX_LAMPS
-    // Latch 0xFF separately without interrupt clear
-    // to park 0xFF in main lamp board
-    RPU_DataWrite(ADDRESS_U10_A, 0xFF);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) | 0x08);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) & 0xF7);
-
-    // For the first four bits of lamps, we're going to look at LampStates[7] again
-    // and use those top 4 bits that we didn't use before. Then we're going
-    // to move on with bytes 8, 9, and 10 for the remaining 24 bits of data
-    byte auxBankNum = 0;
-    for (int lampByteCount=7; lampByteCount<RPU_NUM_LAMP_BANKS; lampByteCount++) {
-      for (byte nibbleCount=0; nibbleCount<2; nibbleCount++) {
-        if (lampByteCount==7) nibbleCount = 1; // skip the first nibble of byte 7 because it belongs to primary lamps
-        byte nibbleOffset = (nibbleCount)?1:16;
-        byte lampOutput = (LampStates[lampByteCount] * nibbleOffset);
-        // Every other time through the cycle, we OR in the dim variable
-        // in order to dim those lights
-        if (numberOfU10Interrupts%DimDivisor1) lampOutput |= (LampDim1[lampByteCount] * nibbleOffset);
-        if (numberOfU10Interrupts%DimDivisor2) lampOutput |= (LampDim2[lampByteCount] * nibbleOffset);
-
-        // The data will be in the upper nibble, but we need the bank count in the lower
-        lampOutput &= 0xF0;
-        lampOutput += auxBankNum;
-
-        interrupts();
-        RPU_DataWrite(ADDRESS_U10_A, 0xFF);
-        noInterrupts();
-
-        RPU_DataWrite(ADDRESS_U10_A, lampOutput | 0xF0);
-        RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL) | 0x08);
-        RPU_DataWrite(ADDRESS_U11_A_CONTROL, RPU_DataRead(ADDRESS_U11_A_CONTROL) & 0xF7);    
-        RPU_DataWrite(ADDRESS_U10_A, lampOutput);
-        
-        auxBankNum += 1;
-      }
-    }
-#endif    
-
-    // Latch 0xFF separately without interrupt clear
-    RPU_DataWrite(ADDRESS_U10_A, 0xFF);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) | 0x08);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, RPU_DataRead(ADDRESS_U10_B_CONTROL) & 0xF7);
+  // Latch 0xFF separately without interrupt clear
+  // to park 0xFF in main lamp board
+  RPU_BusBegin();
+  BusWrite<M6800>(ADDRESS_U10_A, 0xFF);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x38);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x30);
+  RPU_BusEnd();
+
+  // The aux lamps start with the top 4 bits of LampStates[7] (which
+  // the primary lamps didn't use) and go on with bytes 8, 9, and 10.
+  // Their nibbles have the data in the upper nibble and the bank in the lower.
+  for (byte nibbleNum=15; nibbleNum<NUM_LAMP_NIBBLES; nibbleNum++) {
+#if defined(RPU_OS_USE_LAMP_NIBBLE_TABLES) && defined(RPU_OS_USE_LAMP_BRIGHTNESS)
+    byte lampOutput = lampNibbles[nibbleNum] | planeNibbles[nibbleNum];
+#elif defined(RPU_OS_USE_LAMP_NIBBLE_TABLES)
+    byte lampOutput = lampNibbles[nibbleNum];
+#else
+    byte lampOutput = LampNibbleOutputNow(nibbleNum, dimPhases);
+#endif
 
     interrupts();
+    DataWrite<M6800>(ADDRESS_U10_A, 0xFF);
     noInterrupts();
 
-    InsideZeroCrossingInterrupt = 0;
-    RPU_DataWrite(ADDRESS_U10_A, backup10A);
-    RPU_DataWrite(ADDRESS_U10_B_CONTROL, u10BControlLatest);
+    byte u11AControl = RPU_ReadRegisterShadow(ADDRESS_U11_A_CONTROL);
+    RPU_BusBegin();
+    BusWrite<M6800>(ADDRESS_U10_A, lampOutput | 0xF0);
+    BusWrite<M6800>(ADDRESS_U11_A_CONTROL, u11AControl | 0x08);
+    BusWrite<M6800>(ADDRESS_U11_A_CONTROL, u11AControl & 0xF7);    
+    BusWrite<M6800>(ADDRESS_U10_A, lampOutput);
+    RPU_BusEnd();
+  }
+#endif    
+
+  // Latch 0xFF separately without interrupt clear
+  RPU_BusBegin();
+  BusWrite<M6800>(ADDRESS_U10_A, 0xFF);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x38);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x30);
+  RPU_BusEnd();
+
+  // Next dim phase (these wrap at the divisors)
+  LampDimPhase1 += 1;
+  if (LampDimPhase1>=DimDivisor1) LampDimPhase1 = 0;
+  LampDimPhase2 += 1;
+  if (LampDimPhase2>=DimDivisor2) LampDimPhase2 = 0;
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+  LampBrightnessSlot += 1;
+  if (LampBrightnessSlot>=NUM_LAMP_BRIGHTNESS_SLOTS) LampBrightnessSlot = 0;
+#endif
 
-    // Read U10B to clear interrupt
-    RPU_DataRead(ADDRESS_U10_B);
-    numberOfU10Interrupts+=1;
+  interrupts();
+  noInterrupts();
+
+  InsideZeroCrossingInterrupt = 0;
+#ifdef RPU_OS_USE_ISR_STATS
+  // CB1 flags the next crossing even with its interrupt off,
+  // and the read below throws it away
+  if (DataRead<M6800>(ADDRESS_U10_B_CONTROL) & 0x80) RPU_ISR_STATS_SKIPPED_CROSSING();
+#endif
+  RPU_BusBegin();
+  BusWrite<M6800>(ADDRESS_U10_A, SwitchScanBackupU10A);
+  BusWrite<M6800>(ADDRESS_U10_B_CONTROL, SwitchScanU10BControl);
+  RPU_BusEnd();
+
+  RPU_BUS_SECTION(RPU_BUS_SECTION_IRQ_CHECK);
+  // Read U10B to clear interrupt
+  DataRead<M6800>(ADDRESS_U10_B);
+  numberOfU10Interrupts+=1;
+}
+
+template <boolean M6800> void SwitchScanService() {
+  // The display interrupt borrowed U10A (and U10:CB2) while this
+  // column was strobed, so give it a whole tick from now to settle again
+  if (SwitchStrobeDisturbed) {
+    SwitchStrobeDisturbed = false;
+    TCNT2 = 0;
+    return;
+  }
+
+  RPU_BUS_SECTION_SAVE();
+  RPU_TRACE_PASS(BUS_TRACE_SWITCH_SCAN_PASS);
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SWITCHES);
+  byte switchCount = SwitchScanColumn;
+
+  // Read the switches
+  SwitchesNow[switchCount] = DataRead<M6800>(ADDRESS_U10_B);
+
+  //Unset the strobe
+  DataWrite<M6800>(ADDRESS_U10_A, 0x00);
+#if defined(RPU_USE_EXTENDED_SWITCHES_ON_PB4) or defined(RPU_USE_EXTENDED_SWITCHES_ON_PB7)
+  RPU_SetContinuousSolenoidBit(false, ST5_CONTINUOUS_SOLENOID_BIT);
+#endif 
+
+  ProcessSwitchColumn(switchCount);
+
+  switchCount += 1;
+  if (switchCount<NUM_SWITCH_BYTES) {
+    SwitchScanColumn = switchCount;
+    StrobeSwitchColumn<M6800>(switchCount);
+  } else {
+    StopSwitchScanTimer();
+    FinishZeroCrossing<M6800>();
   }
+  RPU_TRACE_PASS_END(BUS_TRACE_SWITCH_SCAN_PASS);
+  RPU_BUS_SECTION_RESTORE();
+}
+
+#if (RPU_OS_HARDWARE_REV==102)
+// Set to the 6800 or 6802/8 build of the handler in RPU_HookInterrupts
+void (*SwitchScanHandler)() = SwitchScanService<BUILT_FOR_M6800>;
+
+ISR(TIMER2_COMPA_vect) {
+  RPU_ISR_STATS_BEGIN();
+  SwitchScanHandler();
+  RPU_ISR_STATS_END(RPU_ISR_SWITCH_SCAN);
+}
+#else
+ISR(TIMER2_COMPA_vect) {
+  RPU_ISR_STATS_BEGIN();
+  SwitchScanService<BUILT_FOR_M6800>();
+  RPU_ISR_STATS_END(RPU_ISR_SWITCH_SCAN);
 }
+#endif
 
+template <boolean M6800> void InterruptService3() {
+  RPU_ISR_STATS_BEGIN();
+  RPU_BUS_SECTION_SAVE();
+  RPU_TRACE_PASS(BUS_TRACE_IRQ_PASS);
+  RPU_BUS_SECTION(RPU_BUS_SECTION_IRQ_CHECK);
+  byte u10AControl = DataRead<M6800>(ADDRESS_U10_A_CONTROL);
+  if (u10AControl & 0x80) {
+    // self test switch
+    if (DataRead<M6800>(ADDRESS_U10_A_CONTROL) & 0x80) PushToSwitchStack(SW_SELF_TEST_SWITCH);
+    DataRead<M6800>(ADDRESS_U10_A);
+  }
+
+  // If we get a weird interupt from U11B, clear it
+  byte u11BControl = DataRead<M6800>(ADDRESS_U11_B_CONTROL);
+  if (u11BControl & 0x80) {
+    DataRead<M6800>(ADDRESS_U11_B);    
+  }
+
+  byte u11AControl = DataRead<M6800>(ADDRESS_U11_A_CONTROL);
+  byte u10BControl = DataRead<M6800>(ADDRESS_U10_B_CONTROL);
+
+  // If the interrupt bit on the display interrupt is on, do the display refresh
+  if (u11AControl & 0x80) {
+    DataRead<M6800>(ADDRESS_U11_A);
+    numberOfU11Interrupts+=1;
+  }
+
+  // If the IRQ bit of U10BControl is set, do the Zero-crossing interrupt handler
+  if ((u10BControl & 0x80) && (InsideZeroCrossingInterrupt==0)) {
+    InsideZeroCrossingInterrupt = InsideZeroCrossingInterrupt + 1;
+
+    SwitchScanU10BControl = RPU_ReadRegisterShadow(ADDRESS_U10_B_CONTROL);
+
+    // Backup contents of U10A
+    SwitchScanBackupU10A = RPU_ReadRegisterShadow(ADDRESS_U10_A);
 
+    // Latch 0xFF separately without interrupt clear
+    RPU_BusBegin();
+    BusWrite<M6800>(ADDRESS_U10_A, 0xFF);
+    BusWrite<M6800>(ADDRESS_U10_B_CONTROL, SwitchScanU10BControl | 0x08);
+    BusWrite<M6800>(ADDRESS_U10_B_CONTROL, SwitchScanU10BControl & 0xF7);
+    RPU_BusEnd();
+    // Read U10B to clear interrupt
+    DataRead<M6800>(ADDRESS_U10_B);
+
+    // Turn off U10BControl interrupts
+    DataWrite<M6800>(ADDRESS_U10_B_CONTROL, 0x30);
+
+    // Strobe the first column and let timer 2 do the rest
+    // of the scan (and then the solenoids & lamps)
+    RPU_BUS_SECTION(RPU_BUS_SECTION_SWITCHES);
+    SwitchScanColumn = 0;
+    SwitchStrobeDisturbed = false;
+    StrobeSwitchColumn<M6800>(0);
+    StartSwitchScanTimer();
+  }
+  RPU_TRACE_PASS_END(BUS_TRACE_IRQ_PASS);
+  RPU_BUS_SECTION_RESTORE();
+  RPU_ISR_STATS_END(RPU_ISR_IRQ);
+}
 
 
 void RPU_HookInterrupts() {
@@ -2935,6 +4812,19 @@ void RPU_HookInterrupts() {
 */  
 
   cli();
+#if (RPU_OS_HARDWARE_REV==102)
+  if (UsesM6800Processor) TimerInterruptHandler = TimerInterruptService<true>;
+  else TimerInterruptHandler = TimerInterruptService<false>;
+  if (UsesM6800Processor) SwitchScanHandler = SwitchScanService<true>;
+  else SwitchScanHandler = SwitchScanService<false>;
+#endif
+  // Timer 2 paces the switch scan, and only runs while
+  // a scan is going (the zero-crossing interrupt starts it)
+  TCCR2A = (1<<WGM21);
+  TCCR2B = 0;
+  TIMSK2 = 0;
+  OCR2A = SWITCH_SCAN_TIMER_COUNTS - 1;
+
   //set timer1 interrupt at 1Hz
   TCCR1A = 0;// set entire TCCR1A register to 0
   TCCR1B = 0;// same for TCCR1B
@@ -2949,7 +4839,12 @@ void RPU_HookInterrupts() {
   TIMSK1 |= (1 << OCIE1A);
   sei();
   
-  attachInterrupt(digitalPinToInterrupt(2), InterruptService3, LOW);
+#if (RPU_OS_HARDWARE_REV==102)
+  if (UsesM6800Processor) attachInterrupt(digitalPinToInterrupt(2), InterruptService3<true>, LOW);
+  else attachInterrupt(digitalPinToInterrupt(2), InterruptService3<false>, LOW);
+#else
+  attachInterrupt(digitalPinToInterrupt(2), InterruptService3<BUILT_FOR_M6800>, LOW);
+#endif
 }
 
 
@@ -3052,9 +4947,12 @@ boolean CheckCreditResetSwitchArch1(byte creditResetSwitch) {
 
 unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditResetSwitch) {
   unsigned long retResult = RPU_RET_NO_ERRORS;
+#if (RPU_OS_HARDWARE_REV<=3)
   // Wait for board to boot
   delayMicroseconds(50000);
   delayMicroseconds(50000);
+  EndBootPhase(RPU_BOOT_PHASE_BOARD_READY);
+#endif
 
 #if (RPU_OS_HARDWARE_REV==1) or (RPU_OS_HARDWARE_REV==2)
   (void)creditResetSwitch;
@@ -3099,7 +4997,7 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   if (bootToOriginal) {
 
     if (DEBUG_MESSAGES) Serial.write("* Asked to boot to original\n");
-    if (DEBUG_MESSAGES) delay(100);
+    if (DEBUG_MESSAGES) Serial.flush();
 
     // Let the 680X run 
     pinMode(14, OUTPUT); // Halt
@@ -3135,8 +5033,9 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   RPU_SetAddressPinsDirection(RPU_PINS_OUTPUT);
 
 #if (RPU_OS_HARDWARE_REV==102)
-  if (CheckForMPUClock()) UsesM6800Processor = true;
+  if (DetectMPUClock()) UsesM6800Processor = true;
   else UsesM6800Processor = false;
+  EndBootPhase(RPU_BOOT_PHASE_CLOCK_CHECK);
 #endif
 
   // Set PHI2 depending on processor type
@@ -3146,7 +5045,16 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
     pinMode(RPU_PHI2_PIN, OUTPUT);
   }
 
-  delay(1000);
+  if (!WaitForBoardReady(ADDRESS_U10_A_CONTROL, 0x38, ADDRESS_U10_B_CONTROL, 0x30)) retResult |= RPU_RET_BOARD_NOT_READY;
+  EndBootPhase(RPU_BOOT_PHASE_BOARD_READY);
+#if (RPU_OS_HARDWARE_REV>=101)
+  if (initOptions&RPU_CMD_AUTODETECT_ARCHITECTURE) {
+    DetectedArchitecture = DetectMPUArchitecture();
+    if (DetectedArchitecture!=BUILT_ARCHITECTURE_FAMILY) retResult |= RPU_RET_ARCHITECTURE_MISMATCH;
+  }
+#else
+  if (initOptions&RPU_CMD_AUTODETECT_ARCHITECTURE) retResult |= RPU_RET_OPTION_NOT_SUPPORTED;
+#endif
 //  RPU_DataWrite(ADDRESS_SB100, 0x01);
   boolean switchStateClosed = false;
   pinMode(RPU_SWITCH_PIN, INPUT);
@@ -3156,7 +5064,9 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   }
 
   boolean creditResetButtonHit = false;
-  if ( creditResetSwitch!=0xFF && (initOptions & (RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_CREDIT_RESET))) {
+  // (if the PIAs never answered, a switch read can't be trusted)
+  if ( creditResetSwitch!=0xFF && !(retResult&(RPU_RET_BOARD_NOT_READY|RPU_RET_ARCHITECTURE_MISMATCH)) && 
+       (initOptions & (RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_CREDIT_RESET))) {
     // We have to check the credit/reset button to honor the init request
     creditResetButtonHit = CheckCreditResetSwitchArch1(creditResetSwitch);
     if (creditResetButtonHit) {
@@ -3165,7 +5075,9 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   }
 
   boolean bootToOriginal = false;
+  // (never drive a board this wasn't built for)
   if (  (initOptions & RPU_CMD_BOOT_ORIGINAL) ||
+        (retResult & RPU_RET_ARCHITECTURE_MISMATCH) ||
         (switchStateClosed && (initOptions&RPU_CMD_BOOT_ORIGINAL_IF_SWITCH_CLOSED)) ||
         (!switchStateClosed && (initOptions&RPU_CMD_BOOT_ORIGINAL_IF_NOT_SWITCH_CLOSED)) ||
         (creditResetButtonHit && (initOptions&RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET)) ||
@@ -3217,23 +5129,24 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   }
 
 #endif  
+  EndBootPhase(RPU_BOOT_PHASE_BOOT_SELECT);
 
   if (DEBUG_MESSAGES) {
     Serial.write("* About to init Arduino ports\n");
-    delay(100);  
+    Serial.flush();  
   }
   SetupArduinoPorts();
 
   // Prep the address bus (all lines zero)
   if (DEBUG_MESSAGES) {
     Serial.write("* About to data read\n");
-    delay(100);  
+    Serial.flush();  
   }
   RPU_DataRead(0);
 
   if (DEBUG_MESSAGES) {
     Serial.write("* DataRead(0) done\n");
-    delay(100);  
+    Serial.flush();  
   }
   
   // Set up the PIAs
@@ -3253,10 +5166,11 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   // Reset address bus
   RPU_DataRead(0);
   RPU_ClearVariables();
+  EndBootPhase(RPU_BOOT_PHASE_PIA_SETUP);
 
   if (DEBUG_MESSAGES) {
     Serial.write("* About to hook interrupts\n");
-    delay(100);  
+    Serial.flush();  
   }
   
   RPU_HookInterrupts();
@@ -3267,8 +5181,10 @@ unsigned long RPU_InitializeMPUArch1(unsigned long initOptions, byte creditReset
   RPU_DataRead(ADDRESS_U11_B);
   RPU_DataRead(ADDRESS_U10_A);
   RPU_DataRead(ADDRESS_U10_B);
-  if (initOptions&RPU_CMD_PERFORM_MPU_TEST) retResult |= RPU_TestPIAs();
+  EndBootPhase(RPU_BOOT_PHASE_INTERRUPTS);
+  if (initOptions&RPU_CMD_PERFORM_MPU_TEST) retResult |= RPU_TestBus();
   RPU_DataRead(0);  // Reset address bus
+  EndBootPhase(RPU_BOOT_PHASE_PIA_TEST);
 
   return retResult;
 }
@@ -3289,11 +5205,20 @@ boolean CheckSwitchStack(byte switchNum) {
 }
 
 
-volatile unsigned long LampPass = 0;
 volatile byte LampStrobe = 0;
+// The switch column that's strobed, and when it went up (TCNT1)
+byte SwitchStrobeColumn = 0;
+unsigned short SwitchStrobeTime = 0;
+// 12 us at timer 1's 16 counts per us
+#define SWITCH_SETTLE_TIMER_COUNTS    (12*16)
 volatile byte DisplayStrobe = 0;
-volatile byte InterruptPass = 0;
-boolean NeedToTurnOffTriggeredSolenoids = true;
+// Solenoids 16-21 are on the PIAs' CA2/CB2 lines (bit 0 = 16).
+// They start out as on so the first pass turns them all off.
+byte TriggeredSolenoidsOn = 0x3F;
+const unsigned short TriggeredSolenoidControl[6] = {
+  PIA_LAMPS_CONTROL_B, PIA_LAMPS_CONTROL_A, PIA_SWITCH_CONTROL_B,
+  PIA_SWITCH_CONTROL_A, PIA_SOLENOID_CONTROL_A, PIA_DISPLAY_CONTROL_B
+};
 #if (RPU_OS_NUM_DIGITS==6)
 byte BlankingBit[16] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x01, 0x02, 0x01, 0x02, 0x04, 0x08, 0x010, 0x20, 0x01, 0x02};
 #elif (RPU_OS_NUM_DIGITS==7) 
@@ -3303,45 +5228,96 @@ volatile byte UpDownPassCounter = 0;
 
 // INTERRUPT HANDLER
 // for ARCH 10 (WMS)
-ISR(TIMER1_COMPA_vect) {    //This is the interrupt request (running at 965.3 Hz)
+// The switch matrix is read four columns an interrupt (so all of it every
+// other interrupt, as before). Each column's read is followed right away by
+// the next column's strobe, and the display, lamp and solenoid work in between
+// is what lets it settle - the last strobe of the pass settles until the next
+// interrupt. Columns strobed in this pass are only read once they've had 12 us.
+template <boolean M6800> void ScanSwitchColumn(boolean strobedThisPass) {
+  if (strobedThisPass) {
+    while ((unsigned short)(TCNT1 - SwitchStrobeTime) < SWITCH_SETTLE_TIMER_COUNTS);
+  }
 
-  byte displayControlPortB = RPU_DataRead(PIA_DISPLAY_CONTROL_B);
-  if (displayControlPortB & 0x80) {
-    UpDownSwitch = true;
-    UpDownPassCounter = 0;
-    // Clear the interrupt
-    RPU_DataRead(PIA_DISPLAY_PORT_B);
-  } else {
-    UpDownPassCounter += 1;
-    if (UpDownPassCounter==50) {
-      UpDownSwitch = false;
-      UpDownPassCounter = 0;
-    }
+  byte switchCol = SwitchStrobeColumn;
+  // Read switch input
+  SwitchesNow[switchCol] = DataRead<M6800>(PIA_SWITCH_PORT_A);
+
+  // Strobe the next column
+  byte nextCol = (switchCol+1) & 0x07;
+  DataWrite<M6800>(PIA_SWITCH_PORT_B, BitShiftValues[nextCol]);
+  SwitchStrobeTime = TCNT1;
+  SwitchStrobeColumn = nextCol;
+
+  // If there are any closures, add them to the switch stack
+  byte validOpens;
+  byte validClosures = DebounceSwitchColumn(switchCol, &validOpens);
+  // If there is a valid switch closure
+  if (validClosures) {
+    // Loop on bits of switch byte
+    for (byte bitCount=0; bitCount<8; bitCount++) {
+      // If this switch bit is closed
+      if (validClosures&0x01) {
+        byte validSwitchNum = switchCol*8 + bitCount;
+        PushToSwitchStack(validSwitchNum);
+      }
+      validClosures = validClosures>>1;
+    }        
   }
 
+  PushSwitchOpens(switchCol, validOpens);
+}
+
+// The timer interrupt's jobs (beyond the display digit and the four
+// switch columns it does every time), by slot. The slots take turns, one
+// per interrupt, and a slot's jobs go in the three gaps that let the
+// switch columns settle (the first one shared with the display digit).
+// Every job is a fixed amount of bus work, so each slot's worst case
+// is bounded (RPU_GetISRStats has them). Each job's bus work fits in its
+// gap, so the slots come out even as long as the jobs' C work stays small.
+#define TIMER_JOB_NONE          0
+#define TIMER_JOB_UP_DOWN       1
+#define TIMER_JOB_LAMPS         2
+#define TIMER_JOB_COIN_DOOR     3
+#define TIMER_JOB_SOLENOIDS     4   /* and sounds */
+#define TIMER_JOBS_PER_SLOT     3
+#define TIMER_NUM_SLOTS         2
+const byte TimerSchedule[TIMER_NUM_SLOTS][TIMER_JOBS_PER_SLOT] = {
+  {TIMER_JOB_UP_DOWN, TIMER_JOB_LAMPS, TIMER_JOB_COIN_DOOR},
+  {TIMER_JOB_UP_DOWN, TIMER_JOB_SOLENOIDS, TIMER_JOB_NONE}
+};
+#if (TIMER_NUM_SLOTS>RPU_MAX_TIMER_SLOTS)
+#error "RPU_MAX_TIMER_SLOTS (RPU.h) has to cover TIMER_NUM_SLOTS"
+#endif
+byte TimerSlot = 0;
+byte LastTimerSlot = 0;
+
+template <boolean M6800> void ShowDisplayDigit() {
 #if (RPU_MPU_ARCHITECTURE==15)
-  // Create display data
-  unsigned int digit1 = 0x0000;
+  // Create display data (the alpha glyphs are already rendered
+  // for the ports, and the ball-in-play digits only use port B)
+  unsigned short digit1 = 0x0000;
   byte digit2 = 0x00;
   byte blankingBit = BlankingBit[DisplayStrobe];
   if (DisplayStrobe==0) {
-    if (DisplayBIPDigitEnable&blankingBit) digit1 = DisplayBIPDigits[0];
+    if (DisplayBIPDigitEnable&blankingBit) digit1 = DisplayBIPDigits[0] & 0x7F;
     if (DisplayCreditDigitEnable&blankingBit) digit2 = DisplayCreditDigits[0];
   } else if (DisplayStrobe<8) {    
-    if (DisplayDigitEnable[0]&blankingBit) digit1 = FourteenSegmentASCII[DisplayText[0][DisplayStrobe-1]];
+    if (DisplayDigitEnable[0]&blankingBit) digit1 = DisplayGlyphs[0][DisplayStrobe-1];
     if (DisplayDigitEnable[2]&blankingBit) digit2 = DisplayDigits[2][DisplayStrobe-1];
   } else if (DisplayStrobe==8) {
-    if (DisplayBIPDigitEnable&blankingBit) digit1 = DisplayBIPDigits[1];
+    if (DisplayBIPDigitEnable&blankingBit) digit1 = DisplayBIPDigits[1] & 0x7F;
     if (DisplayCreditDigitEnable&blankingBit) digit2 = DisplayCreditDigits[1];
   } else {
-    if (DisplayDigitEnable[1]&blankingBit) digit1 = FourteenSegmentASCII[DisplayText[1][DisplayStrobe-9]];
+    if (DisplayDigitEnable[1]&blankingBit) digit1 = DisplayGlyphs[1][DisplayStrobe-9];
     if (DisplayDigitEnable[3]&blankingBit) digit2 = DisplayDigits[3][DisplayStrobe-9];
   }
   // Show current display digit
-  RPU_DataWrite(PIA_DISPLAY_PORT_A, BoardLEDs|DisplayStrobe);
-  RPU_DataWrite(PIA_ALPHA_DISPLAY_PORT_A, (digit1>>7) & 0x7F);
-  RPU_DataWrite(PIA_ALPHA_DISPLAY_PORT_B, digit1 & 0x7F);
-  RPU_DataWrite(PIA_DISPLAY_PORT_B, digit2 & 0x7F);  
+  RPU_BusBegin();
+  BusWrite<M6800>(PIA_DISPLAY_PORT_A, BoardLEDs|DisplayStrobe);
+  BusWrite<M6800>(PIA_ALPHA_DISPLAY_PORT_A, digit1>>8);
+  BusWrite<M6800>(PIA_ALPHA_DISPLAY_PORT_B, digit1 & 0xFF);
+  BusWrite<M6800>(PIA_DISPLAY_PORT_B, digit2 & 0x7F);  
+  RPU_BusEnd();
 #elif (RPU_MPU_ARCHITECTURE==13)
   // Create display data
   byte digit1 = 0x0F, digit2 = 0x0F;
@@ -3379,15 +5355,17 @@ ISR(TIMER1_COMPA_vect) {    //This is the interrupt request (running at 965.3 Hz
     }
   
   }
-  // Show current display digit
-  RPU_DataWrite(PIA_DISPLAY_PORT_A, BoardLEDs|DisplayStrobe);
-  RPU_DataWrite(PIA_DISPLAY_PORT_B, digit1*16 | (digit2&0x0F));
-
   // show commas
-  byte commaByte = RPU_DataRead(PIA_SOUND_COMMA_PORT_B) & 0x3F;
+  byte commaByte = RPU_ReadRegisterShadow(PIA_SOUND_COMMA_PORT_B) & 0x3F;
   if (comma12) commaByte |= 0x80;
   if (comma34) commaByte |= 0x40;
-  RPU_DataWrite(PIA_SOUND_COMMA_PORT_B, commaByte);
+
+  // Show current display digit
+  RPU_BusBegin();
+  BusWrite<M6800>(PIA_DISPLAY_PORT_A, BoardLEDs|DisplayStrobe);
+  BusWrite<M6800>(PIA_DISPLAY_PORT_B, digit1*16 | (digit2&0x0F));
+  BusWrite<M6800>(PIA_SOUND_COMMA_PORT_B, commaByte);
+  RPU_BusEnd();
   
 #else
   // Create display data
@@ -3406,143 +5384,228 @@ ISR(TIMER1_COMPA_vect) {    //This is the interrupt request (running at 965.3 Hz
   }  
   // Show current display digit
 //  if (RPU_DataRead(PIA_DISPLAY_CONTROL_B) & 0x80) SawInterruptOnDisplayPortB1 = true;
-  RPU_DataWrite(PIA_DISPLAY_PORT_A, BoardLEDs|DisplayStrobe);
-  RPU_DataWrite(PIA_DISPLAY_PORT_B, digit1*16 | (digit2&0x0F));
+  RPU_BusBegin();
+  BusWrite<M6800>(PIA_DISPLAY_PORT_A, BoardLEDs|DisplayStrobe);
+  BusWrite<M6800>(PIA_DISPLAY_PORT_B, digit1*16 | (digit2&0x0F));
+  RPU_BusEnd();
 #endif
 
   DisplayStrobe += 1; 
   if (DisplayStrobe>=16) DisplayStrobe = 0;
+}
 
-  if (InterruptPass==0) {
-  
-    // Show lamps
-    byte curLampByte = LampStates[LampStrobe];
-    if (LampPass%DimDivisor1) curLampByte |= LampDim1[LampStrobe];
-    if (LampPass%DimDivisor2) curLampByte |= LampDim2[LampStrobe];
-    RPU_DataWrite(PIA_LAMPS_PORT_B, 0x01<<(LampStrobe));
-    RPU_DataWrite(PIA_LAMPS_PORT_A, curLampByte);
-    
-    LampStrobe += 1;
-    if ((LampStrobe)>=RPU_NUM_LAMP_BANKS) {
-      LampStrobe = 0;
-      LampPass += 1;
-    }
-    
-    // Check coin door switches
-    byte displayControlPortA = RPU_DataRead(PIA_DISPLAY_CONTROL_A);
-    if (displayControlPortA & 0x80) {
-      // If the diagnostic switch isn't on the stack already, put it there
-      if (!CheckSwitchStack(SW_SELF_TEST_SWITCH)) PushToSwitchStack(SW_SELF_TEST_SWITCH);
-      // Clear the interrupt
-      RPU_DataRead(PIA_DISPLAY_PORT_A);
+template <boolean M6800> void CheckUpDownSwitch() {
+  RPU_BUS_SECTION(RPU_BUS_SECTION_IRQ_CHECK);
+  byte displayControlPortB = DataRead<M6800>(PIA_DISPLAY_CONTROL_B);
+  if (displayControlPortB & 0x80) {
+    UpDownSwitch = true;
+    UpDownPassCounter = 0;
+    // Clear the interrupt
+    DataRead<M6800>(PIA_DISPLAY_PORT_B);
+  } else {
+    UpDownPassCounter += 1;
+    if (UpDownPassCounter==50) {
+      UpDownSwitch = false;
+      UpDownPassCounter = 0;
     }
+  }
+}
+
+template <boolean M6800> void ShowLampBank() {
+  RPU_BUS_SECTION(RPU_BUS_SECTION_LAMPS);
+  // Show lamps
+  byte curLampByte = LampStates[LampStrobe];
+  if (LampDimPhase1) curLampByte |= LampDim1[LampStrobe];
+  if (LampDimPhase2) curLampByte |= LampDim2[LampStrobe];
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+  curLampByte |= LampPlaneOff[LampBrightnessSlotPlane[LampBrightnessSlot]][LampStrobe];
+#endif
+  RPU_BusBegin();
+  BusWrite<M6800>(PIA_LAMPS_PORT_B, 0x01<<(LampStrobe));
+  BusWrite<M6800>(PIA_LAMPS_PORT_A, curLampByte);
+  RPU_BusEnd();
+  
+  LampStrobe += 1;
+  if ((LampStrobe)>=RPU_NUM_LAMP_BANKS) {
+    LampStrobe = 0;
+    LampDimPhase1 += 1;
+    if (LampDimPhase1>=DimDivisor1) LampDimPhase1 = 0;
+    LampDimPhase2 += 1;
+    if (LampDimPhase2>=DimDivisor2) LampDimPhase2 = 0;
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+    LampBrightnessSlot += 1;
+    if (LampBrightnessSlot>=NUM_LAMP_BRIGHTNESS_SLOTS) LampBrightnessSlot = 0;
+#endif
+  }
+}
+
+template <boolean M6800> void CheckCoinDoor() {
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SWITCHES);
+  // Check coin door switches
+  byte displayControlPortA = DataRead<M6800>(PIA_DISPLAY_CONTROL_A);
+  if (displayControlPortA & 0x80) {
+    // If the diagnostic switch isn't on the stack already, put it there
+    if (!CheckSwitchStack(SW_SELF_TEST_SWITCH)) PushToSwitchStack(SW_SELF_TEST_SWITCH);
+    // Clear the interrupt
+    DataRead<M6800>(PIA_DISPLAY_PORT_A);
+  }
+}
 
-    // Check switches
-    byte switchColStrobe = 1;
-    for (byte switchCol=0; switchCol<8; switchCol++) {
-      // Cycle the debouncing variables
-      SwitchesMinus2[switchCol] = SwitchesMinus1[switchCol];
-      SwitchesMinus1[switchCol] = SwitchesNow[switchCol];
-      // Turn on the strobe
-      RPU_DataWrite(PIA_SWITCH_PORT_B, switchColStrobe);
-      // Hold it up for 30 us
-      delayMicroseconds(12);
-      // Read switch input
-      SwitchesNow[switchCol] = RPU_DataRead(PIA_SWITCH_PORT_A);
-      switchColStrobe *= 2;
+template <boolean M6800> void UpdateSolenoids() {
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SOLENOIDS);
+  // Coils that have had their passes are done
+  byte numFiring = 0;
+  unsigned short powerUsed = 0;
+  byte groupsUsed = 0;
+  for (byte count=0; count<NumFiringSolenoids; count++) {
+    FiringSolenoidPasses[count] -= 1;
+    if (FiringSolenoidPasses[count]==0) continue;
+    byte solenoidNum = FiringSolenoid[count];
+    FiringSolenoid[numFiring] = solenoidNum;
+    FiringSolenoidPasses[numFiring] = FiringSolenoidPasses[count];
+    powerUsed += SolenoidPower[solenoidNum];
+    groupsUsed |= SolenoidGroups[solenoidNum];
+    numFiring += 1;
+  }
+
+  // Take coils off the front of the stack while they fit the power
+  // budget and don't share a group with a coil that's firing (more
+  // pushes for a firing coil add passes to it). The stack stays in
+  // order: the first coil that doesn't fit waits for the next pass.
+  for (byte count=0; count<SOLENOID_PULLS_PER_PASS; count++) {
+    byte solenoidNum = FirstOnSolenoidStack();
+    if (solenoidNum==SOLENOID_STACK_EMPTY) break;
+    byte firingIndex;
+    for (firingIndex=0; firingIndex<numFiring; firingIndex++) {
+      if (FiringSolenoid[firingIndex]==solenoidNum) break;
     }
-    RPU_DataWrite(PIA_SWITCH_PORT_B, 0);
-    
-    // If there are any closures, add them to the switch stack
-    for (byte switchCol=0; switchCol<NUM_SWITCH_BYTES; switchCol++) {
-      byte validClosures = (SwitchesNow[switchCol] & SwitchesMinus1[switchCol]) & ~SwitchesMinus2[switchCol];
-      // If there is a valid switch closure (off, on, on)
-      if (validClosures) {
-        // Loop on bits of switch byte
-        for (byte bitCount=0; bitCount<8; bitCount++) {
-          // If this switch bit is closed
-          if (validClosures&0x01) {
-            byte validSwitchNum = switchCol*8 + bitCount;
-            PushToSwitchStack(validSwitchNum);
-          }
-          validClosures = validClosures>>1;
-        }        
-      }
+    if (firingIndex<numFiring) {
+      if (FiringSolenoidPasses[firingIndex]==0xFF) break;
+      FiringSolenoidPasses[firingIndex] += 1;
+    } else {
+      if (numFiring==MAX_FIRING_SOLENOIDS) break;
+      if ((powerUsed + SolenoidPower[solenoidNum])>SolenoidPowerBudget) break;
+      if (groupsUsed & SolenoidGroups[solenoidNum]) break;
+      FiringSolenoid[numFiring] = solenoidNum;
+      FiringSolenoidPasses[numFiring] = 1;
+      powerUsed += SolenoidPower[solenoidNum];
+      groupsUsed |= SolenoidGroups[solenoidNum];
+      numFiring += 1;
     }
-  
-  } else {
-    // See if any solenoids need to be switched
-    byte solenoidOn = PullFirstFromSolenoidStack();
-    byte portA = ContinuousSolenoidBits&0xFF;
-    byte portB = ContinuousSolenoidBits/256;
-    if (solenoidOn!=SOLENOID_STACK_EMPTY) {
-      if (solenoidOn<16) {
-        unsigned short newSolenoidBytes = (1<<solenoidOn);
-        portA |= (newSolenoidBytes&0xFF);
-        portB |= (newSolenoidBytes/256);
-        if (NeedToTurnOffTriggeredSolenoids) {
-          RPU_DataWrite(PIA_LAMPS_CONTROL_B, 0x3C);
-          RPU_DataWrite(PIA_LAMPS_CONTROL_A, 0x3C);
-          RPU_DataWrite(PIA_SWITCH_CONTROL_B, 0x3C);
-          RPU_DataWrite(PIA_SWITCH_CONTROL_A, 0x3C);
-          RPU_DataWrite(PIA_SOLENOID_CONTROL_A, 0x3C);
-          RPU_DataWrite(PIA_DISPLAY_CONTROL_B, 0x3D);
-          NeedToTurnOffTriggeredSolenoids = false;
-        }
-      } else {
-        if (solenoidOn==16) RPU_DataWrite(PIA_LAMPS_CONTROL_B, 0x34);
-        if (solenoidOn==17) RPU_DataWrite(PIA_LAMPS_CONTROL_A, 0x34);
-        if (solenoidOn==18) RPU_DataWrite(PIA_SWITCH_CONTROL_B, 0x34);
-        if (solenoidOn==19) RPU_DataWrite(PIA_SWITCH_CONTROL_A, 0x34);
-        if (solenoidOn==20) RPU_DataWrite(PIA_SOLENOID_CONTROL_A, 0x34);
-        if (solenoidOn==21) RPU_DataWrite(PIA_DISPLAY_CONTROL_B, 0x35);
-        NeedToTurnOffTriggeredSolenoids = true;
-      }
-    } else if (NeedToTurnOffTriggeredSolenoids) {
-      NeedToTurnOffTriggeredSolenoids = false;
-      RPU_DataWrite(PIA_LAMPS_CONTROL_B, 0x3C);
-      RPU_DataWrite(PIA_LAMPS_CONTROL_A, 0x3C);
-      RPU_DataWrite(PIA_SWITCH_CONTROL_B, 0x3C);
-      RPU_DataWrite(PIA_SWITCH_CONTROL_A, 0x3C);
-      RPU_DataWrite(PIA_SOLENOID_CONTROL_A, 0x3C);
-      RPU_DataWrite(PIA_DISPLAY_CONTROL_B, 0x3D);
+    PullFirstFromSolenoidStack();
+  }
+  NumFiringSolenoids = numFiring;
+
+  unsigned short solenoidBits = ContinuousSolenoidBits;
+  byte triggeredOn = 0;
+  for (byte count=0; count<numFiring; count++) {
+    if (FiringSolenoid[count]<16) solenoidBits |= (1<<FiringSolenoid[count]);
+    else triggeredOn |= (1<<(FiringSolenoid[count]-16));
+  }
+  byte portA = solenoidBits&0xFF;
+  byte portB = solenoidBits/256;
+
+  RPU_BusBegin();
+  // Only the CA2/CB2 lines that change get written
+  byte triggeredChanged = triggeredOn ^ TriggeredSolenoidsOn;
+  if (triggeredChanged) {
+    for (byte count=0; count<6; count++) {
+      if (!(triggeredChanged & (1<<count))) continue;
+      byte controlValue = (triggeredOn & (1<<count)) ? 0x34 : 0x3C;
+      if (count==5) controlValue |= 0x01;
+      BusWrite<M6800>(TriggeredSolenoidControl[count], controlValue);
     }
+    TriggeredSolenoidsOn = triggeredOn;
+  }
+
 
-  
 #if defined(RPU_OS_USE_WTYPE_1_SOUND)
-    // See if any sounds need to be added
-    // (these are handled through solenoid lines)
-    unsigned short soundOn = PullFirstFromSoundStack();
-    if (soundOn!=SOUND_STACK_EMPTY) {
-      portA |= (soundOn&0xFF);
-      portB |= (soundOn/256);
-    }
+  // See if any sounds need to be added
+  // (these are handled through solenoid lines)
+  unsigned short soundOn = PullFirstFromSoundStack();
+  if (soundOn!=SOUND_STACK_EMPTY) {
+    portA |= (soundOn&0xFF);
+    portB |= (soundOn/256);
+  }
 #elif defined(RPU_OS_USE_WTYPE_2_SOUND)
-    unsigned short soundOn = PullFirstFromSoundStack();
-    if (soundOn!=SOUND_STACK_EMPTY) {
-      RPU_DataWrite(PIA_SOUND_COMMA_PORT_A, (~soundOn) & 0x7F);
-    } else {
-      RPU_DataWrite(PIA_SOUND_COMMA_PORT_A, 0x7F);
-    }
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SOUND);
+  unsigned short soundOn = PullFirstFromSoundStack();
+  if (soundOn!=SOUND_STACK_EMPTY) {
+    BusWrite<M6800>(PIA_SOUND_COMMA_PORT_A, (~soundOn) & 0x7F);
+  } else {
+    BusWrite<M6800>(PIA_SOUND_COMMA_PORT_A, 0x7F);
+  }
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SOLENOIDS);
 #endif    
 
-    RPU_DataWrite(PIA_SOLENOID_PORT_A, portA);
+  BusWrite<M6800>(PIA_SOLENOID_PORT_A, portA);
 #if (RPU_MPU_ARCHITECTURE==15)
-    RPU_DataWrite(PIA_SOLENOID_11_PORT_B, portB);
+  BusWrite<M6800>(PIA_SOLENOID_11_PORT_B, portB);
 #else 
-    RPU_DataWrite(PIA_SOLENOID_PORT_B, portB);
+  BusWrite<M6800>(PIA_SOLENOID_PORT_B, portB);
 #endif    
+  RPU_BusEnd();
+}
+
+template <boolean M6800> void TimerInterruptService() {    //This is the interrupt request (running at 965.3 Hz)
+  RPU_BUS_SECTION_SAVE();
+  RPU_TRACE_PASS(BUS_TRACE_TIMER_PASS);
+
+  // This column was strobed at the end of the last interrupt
+  RPU_BUS_SECTION(RPU_BUS_SECTION_SWITCHES);
+  ScanSwitchColumn<M6800>(false);
+
+  // The digit comes next, always the same time into the
+  // interrupt, so its strobe keeps time
+  RPU_BUS_SECTION(RPU_BUS_SECTION_DISPLAY);
+  ShowDisplayDigit<M6800>();
+
+  for (byte jobNum=0; jobNum<TIMER_JOBS_PER_SLOT; jobNum++) {
+    switch (TimerSchedule[TimerSlot][jobNum]) {
+      case TIMER_JOB_UP_DOWN: CheckUpDownSwitch<M6800>(); break;
+      case TIMER_JOB_LAMPS: ShowLampBank<M6800>(); break;
+      case TIMER_JOB_COIN_DOOR: CheckCoinDoor<M6800>(); break;
+      case TIMER_JOB_SOLENOIDS: UpdateSolenoids<M6800>(); break;
+    }
+    RPU_BUS_SECTION(RPU_BUS_SECTION_SWITCHES);
+    ScanSwitchColumn<M6800>(true);
   }
 
-//  RPU_DataWrite(PIA_SOLENOID_11_PORT_B, InterruptPass);
-  InterruptPass ^= 1;
+  LastTimerSlot = TimerSlot;
+  TimerSlot += 1;
+  if (TimerSlot>=TIMER_NUM_SLOTS) TimerSlot = 0;
+  RPU_TRACE_PASS_END(BUS_TRACE_TIMER_PASS);
+  RPU_BUS_SECTION_RESTORE();
 
 }
 
 
 
+#if (RPU_OS_HARDWARE_REV==102)
+// Set to the 6800 or 6802/8 build of the handler in RPU_HookInterrupts
+void (*TimerInterruptHandler)() = TimerInterruptService<BUILT_FOR_M6800>;
+
+ISR(TIMER1_COMPA_vect) {
+  RPU_ISR_STATS_BEGIN();
+  RPU_ISR_STATS_TIMER_LATE(isrStartCount/16 /* counts are 1/16 us (/1) */);
+  TimerInterruptHandler();
+  RPU_ISR_STATS_END_SLOT(RPU_ISR_TIMER, LastTimerSlot);
+}
+#else
+ISR(TIMER1_COMPA_vect) {
+  RPU_ISR_STATS_BEGIN();
+  RPU_ISR_STATS_TIMER_LATE(isrStartCount/16 /* counts are 1/16 us (/1) */);
+  TimerInterruptService<BUILT_FOR_M6800>();
+  RPU_ISR_STATS_END_SLOT(RPU_ISR_TIMER, LastTimerSlot);
+}
+#endif
+
 void RPU_SetupInterrupt() {
   cli();
+#if (RPU_OS_HARDWARE_REV==102)
+  if (UsesM6800Processor) TimerInterruptHandler = TimerInterruptService<true>;
+  else TimerInterruptHandler = TimerInterruptService<false>;
+#endif
   //set timer1 interrupt at 1Hz
   TCCR1A = 0;// set entire TCCR1A register to 0
   TCCR1B = 0;// same for TCCR1B
@@ -3627,8 +5690,9 @@ unsigned long RPU_InitializeMPUArch10(unsigned long initOptions, byte creditRese
   // 6800 or 6802/8 and possibly override
   // value for UsesM6800Processor
 #if (RPU_OS_HARDWARE_REV==102)
-  if (CheckForMPUClock()) UsesM6800Processor = true;
+  if (DetectMPUClock()) UsesM6800Processor = true;
   else UsesM6800Processor = false;
+  EndBootPhase(RPU_BOOT_PHASE_CLOCK_CHECK);
 #endif
 
   // Set VMA, R/W, and PHI2 to OUTPUT
@@ -3642,10 +5706,15 @@ unsigned long RPU_InitializeMPUArch10(unsigned long initOptions, byte creditRese
     if (DEBUG_MESSAGES) Serial.write("* compiled for 6800\n");
   }
   // Make sure PIA IV (solenoid) CB2 is off so that solenoids are off
+  // (this is also the first register checked for the board coming out of reset)
   RPU_SetAddressPinsDirection(RPU_PINS_OUTPUT);  
-  RPU_DataWrite(PIA_SOLENOID_CONTROL_B, 0x30);
-  
-  delay(1000);
+  if (!WaitForBoardReady(PIA_SOLENOID_CONTROL_B, 0x30, PIA_SWITCH_CONTROL_A, 0x38)) retResult |= RPU_RET_BOARD_NOT_READY;
+  EndBootPhase(RPU_BOOT_PHASE_BOARD_READY);
+  if (initOptions&RPU_CMD_AUTODETECT_ARCHITECTURE) {
+    DetectedArchitecture = DetectMPUArchitecture();
+    if (DetectedArchitecture!=BUILT_ARCHITECTURE_FAMILY) retResult |= RPU_RET_ARCHITECTURE_MISMATCH;
+  }
+
   boolean switchStateClosed = false;
   pinMode(RPU_SWITCH_PIN, INPUT);
   if (digitalRead(RPU_SWITCH_PIN)) {
@@ -3654,7 +5723,9 @@ unsigned long RPU_InitializeMPUArch10(unsigned long initOptions, byte creditRese
   }
 
   boolean creditResetButtonHit = false;
-  if ( creditResetSwitch!=0xFF && (initOptions & (RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_CREDIT_RESET))) {
+  // (if the PIAs never answered, a switch read can't be trusted)
+  if ( creditResetSwitch!=0xFF && !(retResult&(RPU_RET_BOARD_NOT_READY|RPU_RET_ARCHITECTURE_MISMATCH)) && 
+       (initOptions & (RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_CREDIT_RESET))) {
     // We have to check the credit/reset button to honor the init request
     creditResetButtonHit = CheckCreditResetSwitchArch10(creditResetSwitch);
     if (creditResetButtonHit) {
@@ -3664,7 +5735,9 @@ unsigned long RPU_InitializeMPUArch10(unsigned long initOptions, byte creditRese
 
   boolean bootToOriginal = false;
 
+  // (never drive a board this wasn't built for)
   if (  (initOptions & RPU_CMD_BOOT_ORIGINAL) ||
+        (retResult & RPU_RET_ARCHITECTURE_MISMATCH) ||
         (switchStateClosed && (initOptions&RPU_CMD_BOOT_ORIGINAL_IF_SWITCH_CLOSED))  ||
         (!switchStateClosed && (initOptions&RPU_CMD_BOOT_ORIGINAL_IF_NOT_SWITCH_CLOSED))  ||
         (creditResetButtonHit && (initOptions&RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET))  ||
@@ -3729,6 +5802,7 @@ unsigned long RPU_InitializeMPUArch10(unsigned long initOptions, byte creditRese
       while (1);
     }
   }
+  EndBootPhase(RPU_BOOT_PHASE_BOOT_SELECT);
   
 #if (RPU_OS_HARDWARE_REV>100)
   pinMode(RPU_DIAGNOSTIC_PIN, INPUT);
@@ -3738,13 +5812,16 @@ unsigned long RPU_InitializeMPUArch10(unsigned long initOptions, byte creditRese
   RPU_ClearVariables();
   RPU_SetAddressPinsDirection(RPU_PINS_OUTPUT);
   RPU_InitializePIAs();
+  EndBootPhase(RPU_BOOT_PHASE_PIA_SETUP);
   if (initOptions&RPU_CMD_PERFORM_MPU_TEST) {
     if (DEBUG_MESSAGES) Serial.write("* Going to test PIAs\n");
-    retResult |= RPU_TestPIAs();
+    retResult |= RPU_TestBus();
   } else {
     if (DEBUG_MESSAGES) Serial.write("* Not asked to test PIAs\n");    
   }
+  EndBootPhase(RPU_BOOT_PHASE_PIA_TEST);
   RPU_SetupInterrupt();
+  EndBootPhase(RPU_BOOT_PHASE_INTERRUPTS);
 
   return retResult;
 }
@@ -3764,6 +5841,9 @@ void RPU_Update(unsigned long currentTime) {
   
   RPU_ApplyFlashToLamps(currentTime);
   RPU_UpdateTimedSolenoidStack(currentTime);
+#if defined(RPU_OS_ADAPTIVE_DISPLAY_REFRESH)
+  UpdateAdaptiveDisplayRefresh(currentTime);
+#endif
 #if (RPU_MPU_ARCHITECTURE>=10) && (defined(RPU_OS_USE_WTYPE_1_SOUND) || defined(RPU_OS_USE_WTYPE_2_SOUND))
   RPU_UpdateTimedSoundStack(currentTime);
 #endif
@@ -3777,11 +5857,16 @@ unsigned long RPU_InitializeMPU(unsigned long initOptions, byte creditResetSwitc
 
   unsigned long retVal = 0;
 
+  for (byte phase=0; phase<RPU_NUM_BOOT_PHASES; phase++) BootPhaseMicros[phase] = 0;
+  BootPhaseStart = micros();
+
+  RPU_BUS_SECTION(RPU_BUS_SECTION_INIT);
 #if (RPU_MPU_ARCHITECTURE<10)
   retVal = RPU_InitializeMPUArch1(initOptions, creditResetSwitch);
 #else
   retVal = RPU_InitializeMPUArch10(initOptions, creditResetSwitch);
 #endif  
+  RPU_BUS_SECTION(RPU_BUS_SECTION_OTHER);
 
   return retVal;
 }
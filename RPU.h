@@ -44,7 +44,7 @@ struct PlayfieldAndCabinetSwitch {
 #define RPU_CMD_BOOT_ORIGINAL_IF_NOT_CREDIT_RESET   0x0004    /* Only supported on Rev 4 or greater, boots original if the C/R button is NOT held at power on */ 
 #define RPU_CMD_BOOT_ORIGINAL_IF_SWITCH_CLOSED      0x0008    /* boots to original if the switch is closed at power on */
 #define RPU_CMD_BOOT_ORIGINAL_IF_NOT_SWITCH_CLOSED  0x0010    /* boots to original if the switch is NOT closed at power on */
-#define RPU_CMD_AUTODETECT_ARCHITECTURE             0x0040    /* For Rev 101 and greater--the code detects architecture of board (mainly for diagnostics applications) */
+#define RPU_CMD_AUTODETECT_ARCHITECTURE             0x0040    /* For Rev 101 and greater--checks the board against RPU_MPU_ARCHITECTURE, and boots original if it's a different board (RPU_RET_ARCHITECTURE_MISMATCH) */
 #define RPU_CMD_PERFORM_MPU_TEST                    0x0080    /* perform basic tests on PIAs and return result codes */
 
 // If the caller chooses this option, it's up to them
@@ -63,22 +63,116 @@ struct PlayfieldAndCabinetSwitch {
 #define RPU_RET_OPTION_NOT_SUPPORTED      0x0080
 #define RPU_RET_6800_DETECTED             0x0100
 #define RPU_RET_6802_OR_8_DETECTED        0x0200
+#define RPU_RET_BOARD_NOT_READY           0x0400
+#define RPU_RET_ARCHITECTURE_MISMATCH     0x0800    /* RPU_CMD_AUTODETECT_ARCHITECTURE found a different board than RPU_MPU_ARCHITECTURE */
 #define RPU_RET_DIAGNOSTIC_REQUESTED      0x1000
 #define RPU_RET_SELECTOR_SWITCH_ON        0x2000
 #define RPU_RET_CREDIT_RESET_BUTTON_HIT   0x4000
 #define RPU_RET_ORIGINAL_CODE_REQUESTED   0x8000
+#define RPU_RET_DATA_LINE_ERROR           0x00010000  /* a data line was stuck or shorted in RPU_TestBus */
+
+// Bus section tags - used to attribute bus cycles
+// to the part of the interrupt code that issued them
+#define RPU_BUS_SECTION_OTHER             0
+#define RPU_BUS_SECTION_DISPLAY           1
+#define RPU_BUS_SECTION_SWITCHES          2
+#define RPU_BUS_SECTION_SOLENOIDS         3
+#define RPU_BUS_SECTION_LAMPS             4
+#define RPU_BUS_SECTION_SOUND             5
+#define RPU_BUS_SECTION_IRQ_CHECK         6
+#define RPU_BUS_SECTION_INIT              7
+
+// Boot phases - RPU_GetBootPhaseMicros returns the time
+// the last RPU_InitializeMPU spent in each one
+#define RPU_BOOT_PHASE_CLOCK_CHECK        0
+#define RPU_BOOT_PHASE_BOARD_READY        1
+#define RPU_BOOT_PHASE_BOOT_SELECT        2
+#define RPU_BOOT_PHASE_PIA_SETUP          3
+#define RPU_BOOT_PHASE_PIA_TEST           4
+#define RPU_BOOT_PHASE_INTERRUPTS         5
+#define RPU_NUM_BOOT_PHASES               6
+
+// Results of the extended PIA / bus test (RPU_TestBus)
+struct RPUBusTestResults {
+  unsigned long piaErrors;          // RPU_RET_ PIA and data line error flags
+  byte stuckHighLines;              // data lines (bit 0 = D0) that never read low
+  byte stuckLowLines;               // data lines that never read high
+  byte shortedLines;                // data lines that read wrong, but not stuck
+  unsigned short readNanoseconds;   // average RPU_DataRead
+  unsigned short writeNanoseconds;  // average RPU_DataWrite
+};
+
+// Interrupt handlers timed for RPU_GetISRStats
+#define RPU_ISR_TIMER                     0   /* timer 1 - displays on Arch 1, everything on the others */
+#define RPU_ISR_SWITCH_SCAN               1   /* timer 2 - Arch 1 switch scan, solenoids & lamps */
+#define RPU_ISR_IRQ                       2   /* MPU IRQ - Arch 1 zero crossing */
+#define RPU_NUM_ISRS                      3
+#define RPU_MAX_TIMER_SLOTS               4   /* Arch 10+ timer interrupt schedule */
+
+// Interrupt timing (RPU_OS_USE_ISR_STATS), in microseconds
+// (times include any interrupt that nests inside)
+struct RPUISRStats {
+  unsigned long calls[RPU_NUM_ISRS];
+  unsigned short averageMicros[RPU_NUM_ISRS];  // moving average of about the last 8 calls
+  unsigned short maxMicros[RPU_NUM_ISRS];
+  unsigned short maxTimerSlotMicros[RPU_MAX_TIMER_SLOTS];  // Arch 10+ timer worst case by schedule slot
+  unsigned short maxTimerLateMicros;           // worst timer 1 entry after it was due
+  unsigned short maxMaskedMicros;              // longest the library's main-loop code held interrupts off
+  unsigned long skippedZeroCrossings;          // Arch 1 crossings that came in before the last one was done
+  unsigned short displayRefreshConstant;       // Arch 1 OCR1A (RPU_OS_SOFTWARE_DISPLAY_INTERRUPT_INTERVAL unless changed)
+  unsigned short displayRefreshChanges;        // times RPU_OS_ADAPTIVE_DISPLAY_REFRESH changed it
+  unsigned short loopsPerSecond;               // RPU_Update calls per second, as the adaptive refresh last saw it
+};
+
+// A switch stack entry (RPU_PullFirstSwitchEvent)
+#define RPU_SWITCH_EDGE_CLOSED            0
+#define RPU_SWITCH_EDGE_OPENED            1
+struct RPUSwitchEvent {
+  byte switchNum;
+  byte edge;                        // RPU_SWITCH_EDGE_
+  unsigned long detectedMicros;     // micros() when the interrupt saw it (or when it was pushed) - when it was pulled without RPU_OS_USE_SWITCH_EVENT_TIMES
+  byte count;                       // closures it stands for (more than 1 only for RPU_SetSwitchCoalescing switches, 1 without RPU_OS_USE_SWITCH_COALESCING)
+};
 
 // Function Prototypes
 
 //   Initialization
+// RPU_InitializeMPU takes timer 1 on every board, and on Arch 1 timer 2
+// as well (it paces the switch scan). Arch 1 games can't use tone() or
+// analogWrite on the timer 2 pins (3 and 11 on an Uno/Nano, 9 and 10 on
+// a Mega). The timer 1 pins and the Servo library are out everywhere.
 unsigned long RPU_InitializeMPU(  
   unsigned long initOptions = RPU_CMD_BOOT_ORIGINAL_IF_CREDIT_RESET | RPU_CMD_BOOT_ORIGINAL_IF_NOT_SWITCH_CLOSED | RPU_CMD_PERFORM_MPU_TEST, 
   byte creditResetSwitch = 0xFF );
+unsigned long RPU_GetBootPhaseMicros(byte phase);
+byte RPU_GetDetectedArchitecture(); // 1, 11 (Sys 4, 6 or 7), 15, or 0 if not detected
+unsigned long RPU_TestBus(RPUBusTestResults *results=NULL);
+void RPU_GetBusTestResults(RPUBusTestResults *results); // from the last RPU_TestBus
+void RPU_GetISRStats(RPUISRStats *stats); // all zeros without RPU_OS_USE_ISR_STATS
+void RPU_ResetISRStats();
 void RPU_SetupGameSwitches(int s_numSwitches, int s_numPrioritySwitches, PlayfieldAndCabinetSwitch *s_gameSwitchArray);
 byte RPU_GetDipSwitches(byte index);
 
 //   Swtiches
 byte RPU_PullFirstFromSwitchStack();
+boolean RPU_PullFirstSwitchEvent(RPUSwitchEvent *switchEvent); // false if the stack is empty
+void RPU_SetSwitchOpenEvents(byte switchNum, boolean reportOpens = true); // opens only come out of RPU_PullFirstSwitchEvent
+#ifdef RPU_OS_USE_SWITCH_COALESCING
+// For spinners, pops and the like: the switch keeps one closure on the
+// stack, and closures that come in before it's pulled are added to its
+// count (up to 255), so it can't fill the stack. RPU_PullFirstSwitchEvent
+// returns the count; RPU_PullFirstFromSwitchStack returns the switch
+// that many times.
+void RPU_SetSwitchCoalescing(byte switchNum, boolean coalesce = true);
+#endif
+#ifdef RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+// Samples in a row (1-7) it takes to close or open (by default 2 to
+// close and 1 to open), and the shortest time from one closure to the
+// next (closures sooner than that are dropped). Arch 1 samples every switch once per zero crossing
+// (8.3 ms), the others about every 2 ms, so the time is rounded up to
+// that and tops out at 255 samples.
+void RPU_SetSwitchDebounce(byte switchNum, byte samplesToClose, byte samplesToOpen, unsigned short minRetriggerMillis = 0);
+#endif
 boolean RPU_ReadSingleSwitchState(byte switchNum);
 void RPU_PushToSwitchStack(byte switchNumber);
 boolean RPU_GetUpDownSwitchState(); // This always returns true for RPU_MPU_ARCHITECTURE==1 (no up/down switch)
@@ -91,6 +185,12 @@ void RPU_SetDisableFlippers(boolean disableFlippers = true, byte solbit = CONTSO
 void RPU_SetContinuousSolenoidBit(boolean bitOn, byte solBit = 0x10);
 #if (RPU_MPU_ARCHITECTURE>=10)
 void RPU_SetContinuousSolenoid(boolean solOn, byte solNum);
+// Pushed coils fire together as long as their power adds up to no more
+// than the budget and they share no group bits (coils on the same fuse
+// or supply leg). Every coil is power 1 with no groups, and the budget
+// is 1, so by default coils fire one at a time.
+void RPU_SetSolenoidPowerBudget(byte maxPower);
+void RPU_SetSolenoidPower(byte solenoidNumber, byte power, byte groups = 0);
 #endif
 boolean RPU_FireContinuousSolenoid(byte solBit, byte numCyclesToFire);
 byte RPU_ReadContinuousSolenoids();
@@ -110,11 +210,24 @@ void RPU_SetDisplayFlashCredits(unsigned long curTime, int period=100);
 void RPU_CycleAllDisplays(unsigned long curTime, byte digitNum=0); // Self-test function
 byte RPU_GetDisplayBlank(int displayNumber);
 #if (RPU_MPU_ARCHITECTURE==15)
-byte RPU_SetDisplayText(int displayNumber, char *text, boolean blankByLength=true);
+// Alpha display glyphs are FourteenSegmentASCII words, plus these
+#define RPU_GLYPH_DECIMAL   0x4000
+#define RPU_GLYPH_COMMA     0x8000
+// With foldPunctuation, a '.' or ',' right after a character lights that
+// character's decimal point or comma instead of taking a digit of its own
+byte RPU_SetDisplayText(int displayNumber, char *text, boolean blankByLength=true, boolean foldPunctuation=false);
+void RPU_SetDisplayGlyph(int displayNumber, byte digitNum, unsigned short glyph);
 #endif
 #if defined(RPU_OS_ADJUSTABLE_DISPLAY_INTERRUPT)
 void RPU_SetDisplayRefreshConstant(int intervalConstant);
 #endif
+#if defined(RPU_OS_ADAPTIVE_DISPLAY_REFRESH)
+// RPU_Update moves the refresh constant between fastestConstant (e.g. 35 = 434 Hz)
+// and slowestConstant, staying as fast as it can while the main loop makes
+// minLoopsPerSecond and the display interrupt takes at most maxDisplayDutyPercent.
+// A fastestConstant of 0 turns it off (and leaves the refresh where it is).
+void RPU_SetAdaptiveDisplayRefresh(byte fastestConstant, byte slowestConstant, unsigned short minLoopsPerSecond, byte maxDisplayDutyPercent=10);
+#endif
 
 //   Lamps
 void RPU_SetLampState(int lampNum, byte s_lampState, byte s_lampDim=0, int s_lampFlashPeriod=0);
@@ -125,6 +238,10 @@ void RPU_SetDimDivisor(byte level=1, byte divisor=2); // 2 means 50% duty cycle,
 byte RPU_ReadLampState(int lampNum);
 byte RPU_ReadLampDim(int lampNum);
 int RPU_ReadLampFlash(int lampNum);
+#ifdef RPU_OS_USE_LAMP_BRIGHTNESS
+void RPU_SetLampBrightness(int lampNum, byte brightness); // 0-15, 15 (the default) is full
+byte RPU_ReadLampBrightness(int lampNum);
+#endif
 
 // Sound Functions
 #ifdef RPU_OS_USE_S_AND_T
@@ -161,6 +278,16 @@ void RPU_PlayW11Music(byte songNum);
 
 //   General Utility
 byte RPU_DataRead(int address);
+byte RPU_ReadRegisterShadow(int address);
+void RPU_SetRegisterBits(int address, byte bits);
+void RPU_ClearRegisterBits(int address, byte bits);
+// Interrupts have to stay off from RPU_BusBegin to RPU_BusEnd
+void RPU_BusBegin();
+void RPU_BusWrite(int address, byte data);
+void RPU_BusEnd();
+#ifdef RPU_OS_USE_BUS_TRACE
+void RPU_DumpBusTrace();
+#endif
 void RPU_Update(unsigned long currentTime);
 #if RPU_MPU_ARCHITECTURE>9
 void RPU_SetBoardLEDs(boolean LED1, boolean LED2, byte BCDValue = 0xFF);
@@ -195,8 +322,9 @@ const uint16_t SevenSegmentNumbers[10] = {
   0x6F  /* 9 */
 };
 
-// alphanumeric 14-segment display (ASCII)
-const uint16_t FourteenSegmentASCII[96] = {
+// alphanumeric 14-segment display (ASCII), kept in flash
+// (read it with pgm_read_word)
+const uint16_t FourteenSegmentASCII[96] PROGMEM = {
   0x0000,/*   converted 0x0000 to 0x0000*/
   0x0006,/* ! converted 0x4006 to 0x0006*/
   0x0102,/* " converted 0x0202 to 0x0102*/
@@ -33,21 +33,30 @@
 // Hardware Rev 100 (different order of magnitude because it's a different approach) plugs into the CPU socket
 // Hardware Rev 101 - first RPU CPU interposer release board
 // Hardware Rev 102 - second RPU (with display and WIFI socket)
+// (the rev, architecture, and 6800 settings can also be given on the compiler command line)
+#ifndef RPU_OS_HARDWARE_REV
 #define RPU_OS_HARDWARE_REV   4
+#endif
 
 // Available Architectures (0-9 is for B/S Boards, 10-19 is for W)
 //  RPU_MPU_ARCHITECTURE 1 = -17, -35, 100, 200, or compatible
 //  RPU_MPU_ARCHITECTURE 11 = Sys 4, 6
 //  RPU_MPU_ARCHITECTURE 13 = Sys 7
 //  RPU_MPU_ARCHITECTURE 15 = Sys 11
+// Each architecture is its own build. RPU_CMD_AUTODETECT_ARCHITECTURE
+// (Rev 101+) only catches a build that went on the wrong board.
+#ifndef RPU_MPU_ARCHITECTURE
 #define RPU_MPU_ARCHITECTURE  1
+#endif
 
 // Some boards will assume a 6800 is the processor (RPU_OS_HARDWARE_REV 1 through 4)
 // and some boards will try to detect the processor (RPU_OS_HARDWARE_REV 102)
 // but in other cases we can specify if we're building for a 6800.
 // Define RPU_MPU_BUILD_FOR_6800 with a 0 for 6802 or 6808, and with
 // a 1 for 6800
+#ifndef RPU_MPU_BUILD_FOR_6800
 #define RPU_MPU_BUILD_FOR_6800  1
+#endif
 
 // These defines allow this configuration to eliminate some functions
 // to reduce program size
@@ -67,6 +76,65 @@
 //#define RPU_OS_USE_WTYPE_2_SOUND
 //#define RPU_OS_USE_W11_SOUND
 
+// Records bus cycles in a ring buffer (RPU_BUS_TRACE_SIZE entries,
+// 4 bytes each) that RPU_DumpBusTrace sends out over Serial.
+// Debugging only - it costs RAM and time in every bus access.
+//#define RPU_OS_USE_BUS_TRACE
+//#define RPU_BUS_TRACE_SIZE  256
+
+// Times every interrupt handler for RPU_GetISRStats (and adds a
+// self-test page). Tuning only - it costs two timer count reads and
+// the bookkeeping in every interrupt, plus about 50 bytes of RAM.
+//#define RPU_OS_USE_ISR_STATS
+
+// Time-stamps every switch stack entry for RPUSwitchEvent::detectedMicros.
+// It's 4 bytes per entry (240 bytes of RAM), so it's left off on the
+// Rev 1/2 Nano (2 KB), where detectedMicros is when the event was pulled.
+#if (RPU_OS_HARDWARE_REV>2)
+#define RPU_OS_USE_SWITCH_EVENT_TIMES
+#endif
+
+// Adds RPU_SetLampBrightness (16 levels per lamp). It's 4 bytes per
+// lamp bank (32 bytes, 44 with aux lamps, and as much again with
+// RPU_OS_USE_LAMP_NIBBLE_TABLES), so it's left off on the Rev 1/2 Nano.
+#if (RPU_OS_HARDWARE_REV>2)
+#define RPU_OS_USE_LAMP_BRIGHTNESS
+#endif
+
+// Keeps the Arch 1 lamp data ready to write for every dim phase (and
+// brightness plane), so the zero-crossing interrupt only copies it out.
+// It's 4 bytes per lamp bank (32 bytes, 44 with aux lamps), so it's left
+// off on the Rev 1/2 Nano, where the interrupt works each nibble out.
+#if (RPU_OS_HARDWARE_REV>2)
+#define RPU_OS_USE_LAMP_NIBBLE_TABLES
+#endif
+
+// Adds RPU_SetSwitchDebounce (samples to close and open, and a minimum
+// re-trigger time, per switch). It's 26 bytes per switch column (208
+// bytes), so it's left off on the Rev 1/2 Nano, where every switch takes
+// 2 samples to close and 1 to open.
+#if (RPU_OS_HARDWARE_REV>2)
+#define RPU_OS_USE_SWITCH_DEBOUNCE_PROFILES
+#endif
+
+// Adds RPU_SetSwitchCoalescing (one stack entry with a count for a
+// spinner or pop). It's a count per switch (up to 72 bytes), so it's
+// left off on the Rev 1/2 Nano, where every closure is an entry of its own.
+#if (RPU_OS_HARDWARE_REV>2)
+#define RPU_OS_USE_SWITCH_COALESCING
+#endif
+
+// Keeps the Arch 1 game switch table by switch number, so the switch
+// interrupt finds a switch's solenoid without walking the sketch's
+// array. It's 128 bytes, so it's left off on the Rev 1/2 Nano.
+#if (RPU_OS_HARDWARE_REV>2)
+#define RPU_OS_USE_SWITCH_SOLENOID_TABLE
+#endif
+
+// At boot, the longest RPU_InitializeMPU will wait for the MPU
+// board to come out of reset (it polls, so it's usually far less)
+#define RPU_OS_BOOT_TIMEOUT_IN_MILLISECONDS   1000
+
 
 
 
@@ -93,6 +161,9 @@
 //  34            446.4 Hz      
 #define RPU_OS_SOFTWARE_DISPLAY_INTERRUPT_INTERVAL  48  
 //#define RPU_OS_ADJUSTABLE_DISPLAY_INTERRUPT
+// With the adjustable interrupt (and RPU_OS_USE_ISR_STATS), RPU_Update
+// can pick the value itself within limits - see RPU_SetAdaptiveDisplayRefresh
+//#define RPU_OS_ADAPTIVE_DISPLAY_REFRESH
 
 #ifdef RPU_OS_USE_6_DIGIT_CREDIT_DISPLAY_WITH_7_DIGIT_DISPLAYS
 #define RPU_OS_MASK_SHIFT_1            0x60
@@ -115,6 +186,8 @@
 #define CONTSOL_DISABLE_FLIPPERS      0x40
 #define CONTSOL_DISABLE_COIN_LOCKOUT  0x20
 
+// Timer 2 strobes the switch columns this far apart (1024 us at most), so
+// tone() and PWM on the timer 2 pins (3/11 Uno, 9/10 Mega) can't be used
 #define RPU_OS_SWITCH_DELAY_IN_MICROSECONDS 200
 #define RPU_OS_TIMING_LOOP_PADDING_IN_MICROSECONDS  70
 
@@ -168,6 +241,7 @@
 #define RPU_CPC_CHUTE_1_SELECTION_BYTE            50
 #define RPU_CPC_CHUTE_2_SELECTION_BYTE            51
 #define RPU_CPC_CHUTE_3_SELECTION_BYTE            52
+#define RPU_MPU_CLOCK_EEPROM_START_BYTE           53
 
 #define RPU_CONFIG_H
 #endif
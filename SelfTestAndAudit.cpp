@@ -37,6 +37,15 @@ byte CurSound = 0x01;
 byte SoundPlaying = 0;
 byte SoundToPlay = 0;
 boolean SolenoidCycle = true;
+#ifdef RPU_OS_USE_ISR_STATS
+#ifdef RPU_OS_ADAPTIVE_DISPLAY_REFRESH
+#define NUM_ISR_STATS_PAGES   4
+#else
+#define NUM_ISR_STATS_PAGES   3
+#endif
+byte ISRStatsPage = 0;
+unsigned long LastISRStatsUpdate = 0;
+#endif
 
 #ifndef RPU_OS_DISABLE_CPC_FOR_SPACE
 boolean CPCSelectionsHaveBeenRead = false;
@@ -380,6 +389,52 @@ int RunBaseSelfTest(int curState, boolean curStateChanged, unsigned long Current
     auditNumStartByte = RPU_CHUTE_1_COINS_START_BYTE;
   } else if (curState==MACHINE_STATE_TEST_CHUTE_3_COINS) {
     auditNumStartByte = RPU_CHUTE_3_COINS_START_BYTE;
+#ifdef RPU_OS_USE_ISR_STATS
+  } else if (curState==MACHINE_STATE_TEST_ISR_STATS) {
+    // Reset steps through the pages (display 4 shows which),
+    // double-click clears the stats:
+    //   1: worst timer, switch scan & IRQ handler times (us)
+    //   2: average timer, switch scan & IRQ handler times (us)
+    //   3: longest masked stretch, worst timer lateness (us), skipped crossings
+    //   4: (adaptive refresh) display refresh constant, changes, loops/s
+    if (curStateChanged) {
+      ISRStatsPage = 0;
+      LastISRStatsUpdate = 0;
+    }
+    if (curSwitch==resetSwitch) {
+      ISRStatsPage += 1;
+      if (ISRStatsPage>=NUM_ISR_STATS_PAGES) ISRStatsPage = 0;
+      LastISRStatsUpdate = 0;
+    }
+    if (resetDoubleClick) {
+      RPU_ResetISRStats();
+      ISRStatsPage = 0;
+      LastISRStatsUpdate = 0;
+    }
+    if (LastISRStatsUpdate==0 || (CurrentTime-LastISRStatsUpdate)>500) {
+      RPUISRStats stats;
+      RPU_GetISRStats(&stats);
+      if (ISRStatsPage==0) {
+        RPU_SetDisplay(0, stats.maxMicros[RPU_ISR_TIMER], true);
+        RPU_SetDisplay(1, stats.maxMicros[RPU_ISR_SWITCH_SCAN], true);
+        RPU_SetDisplay(2, stats.maxMicros[RPU_ISR_IRQ], true);
+      } else if (ISRStatsPage==1) {
+        RPU_SetDisplay(0, stats.averageMicros[RPU_ISR_TIMER], true);
+        RPU_SetDisplay(1, stats.averageMicros[RPU_ISR_SWITCH_SCAN], true);
+        RPU_SetDisplay(2, stats.averageMicros[RPU_ISR_IRQ], true);
+      } else if (ISRStatsPage==2) {
+        RPU_SetDisplay(0, stats.maxMaskedMicros, true);
+        RPU_SetDisplay(1, stats.maxTimerLateMicros, true);
+        RPU_SetDisplay(2, stats.skippedZeroCrossings, true);
+      } else {
+        RPU_SetDisplay(0, stats.displayRefreshConstant, true);
+        RPU_SetDisplay(1, stats.displayRefreshChanges, true);
+        RPU_SetDisplay(2, stats.loopsPerSecond, true);
+      }
+      RPU_SetDisplay(3, ISRStatsPage+1, true);
+      LastISRStatsUpdate = CurrentTime;
+    }
+#endif
 #ifndef RPU_OS_DISABLE_CPC_FOR_SPACE      
   } else if (curState==MACHINE_STATE_ADJUST_CPC_CHUTE_1) {
     cpcSelectorStartByte = RPU_CPC_CHUTE_1_SELECTION_BYTE;
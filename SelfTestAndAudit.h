@@ -60,14 +60,21 @@
 #define MACHINE_STATE_TEST_CHUTE_3_COINS  -17
 #endif 
 
+#ifdef RPU_OS_USE_ISR_STATS
+#define MACHINE_STATE_TEST_ISR_STATS      -18
+#define MACHINE_STATE_TEST_LAST_AUDIT     -18
+#else
+#define MACHINE_STATE_TEST_LAST_AUDIT     -17
+#endif
+
 #ifndef RPU_OS_DISABLE_CPC_FOR_SPACE  
-#define MACHINE_STATE_ADJUST_CPC_CHUTE_1        -18
-#define MACHINE_STATE_ADJUST_CPC_CHUTE_2        -19 
-#define MACHINE_STATE_ADJUST_CPC_CHUTE_3        -20
+#define MACHINE_STATE_ADJUST_CPC_CHUTE_1        (MACHINE_STATE_TEST_LAST_AUDIT-1)
+#define MACHINE_STATE_ADJUST_CPC_CHUTE_2        (MACHINE_STATE_TEST_LAST_AUDIT-2)
+#define MACHINE_STATE_ADJUST_CPC_CHUTE_3        (MACHINE_STATE_TEST_LAST_AUDIT-3)
 // This define is set to the last test, so the extended settings will know when to take over
-#define MACHINE_STATE_TEST_DONE           -20
+#define MACHINE_STATE_TEST_DONE           (MACHINE_STATE_TEST_LAST_AUDIT-3)
 #else
-#define MACHINE_STATE_TEST_DONE           -17
+#define MACHINE_STATE_TEST_DONE           MACHINE_STATE_TEST_LAST_AUDIT
 #endif
 
 unsigned long GetLastSelfTestChangedTime();